@@ -1,15 +1,23 @@
 #ifndef BLOCKS_H
 #define BLOCKS_H
 
+#ifndef CZM_HEADLESS
 #if __APPLE__
 #include <GLUT/glut.h>
 #else
 #include <GL/glut.h>
 #endif
+#endif // CZM_HEADLESS
 
 #include "Materials.h"
 #include "Grid.h"
+#include "ThreadPool.h"
+#include "SpatialHash.h"
+#include "Precision.h"
+#include "Checkpoint.h"
 #include <vector>
+#include <algorithm>
+#include <limits>
 #include <math.h>
 
 class Blocks {
@@ -26,7 +34,8 @@ public:
     iinertia.clear();
     px.clear();
     py.clear();
-    rz.clear();
+    cz.clear();
+    sz.clear();
     vx.clear();
     vy.clear();
     wz.clear();
@@ -34,15 +43,39 @@ public:
     fy.clear();
     mz.clear();
     fixity.clear();
+    boundary.clear();
 
-    player_mat = nullptr;
-    player_mass = 0.0;
-    player_px = 0.0;
-    player_py = 0.0;
-    player_vx = 0.0;
-    player_vy = 0.0;
-    player_fx = 0.0;
-    player_fy = 0.0;
+    Nbodies = 0;
+    body_mat.clear();
+    body_mass.clear();
+    body_px.clear();
+    body_py.clear();
+    body_vx.clear();
+    body_vy.clear();
+    body_fx.clear();
+    body_fy.clear();
+    broadphaseStale = true;
+    bonds.clear();
+    fragment.clear();
+    Nfragments = 0;
+    fragmentPairs.clear();
+    verletStale = true;
+    Nclusters = 0;
+    cluster.clear();
+    clusterStart.assign(1, 0);
+    clusterBlocks.clear();
+    cluster_split.clear();
+    cluster_strength.clear();
+    cluster_mass.clear();
+    cluster_iinertia.clear();
+    cluster_px.clear();
+    cluster_py.clear();
+    cluster_cz.clear();
+    cluster_sz.clear();
+    cluster_vx.clear();
+    cluster_vy.clear();
+    cluster_wz.clear();
+    pendingSplit = false;
   } // clear()
 
   void initialize(Grid& grid) {
@@ -55,13 +88,10 @@ public:
 	int cell_id = grid.Nx*j+i;
 	grid.blockIDs[cell_id] = -1;
 	if (grid.cells[cell_id] != nullptr) {
-	  float area = L*L;
-	  float value = grid.cells[cell_id]->density * area;
+	  Scalar area = L*L;
+	  Scalar value = grid.cells[cell_id]->density * area;
 	  if (grid.cells[cell_id]->name == "Player") {
-	    player_mat = grid.cells[cell_id];
-	    player_mass = value;
-	    player_px = L*(i+0.5);
-	    player_py = L*(j+0.5);
+	    addBody(grid.cells[cell_id], value, L*(i+0.5), L*(j+0.5));
 	  } else {
 	    mat.push_back(grid.cells[cell_id]);
 	    mass.push_back(value);
@@ -70,7 +100,8 @@ public:
 	    iinertia.push_back(6.0*value/area);
 	    px.push_back(L*(i+0.5));
 	    py.push_back(L*(j+0.5));
-	    rz.push_back(0.0);
+	    cz.push_back(1.0);
+	    sz.push_back(0.0);
 	    vx.push_back(0.0);
 	    vy.push_back(0.0);
 	    wz.push_back(0.0);
@@ -78,268 +109,990 @@ public:
 	    fy.push_back(0.0);
 	    mz.push_back(0.0);
 	    fixity.push_back(1.0);
-	    if ((i == 0) || (j == 0) || (i == (grid.Nx-1)) || (j == (grid.Ny-1))) fixity[Nblocks] = 0.0;
+	    if ((i == 0) || (j == 0) || (i == (grid.Nx-1)) || (j == (grid.Ny-1))) {
+	      fixity[Nblocks] = 0.0;
+	      boundary.push_back(Nblocks);
+	    }
 	    grid.blockIDs[cell_id] = Nblocks;
 	    Nblocks++;
 	  } // if (grid.cells[cell_id].name == "Player")
 	} // if (grid.cells[cell_id] != nullptr)
       } // for i = ...
     } // for j = ...
+
+    // initially, every block is bonded (by a cohesive face) to each of its grid neighbors
+    bonds.assign(4*Nblocks, -1);
+    fragment.assign(Nblocks, 0);
+    level.assign(Nblocks, 0);
+    finestLevel = 0;
+    asleep.assign(Nblocks, 0);
+    quietSteps.assign(Nblocks, 0);
+    island.assign(Nblocks, -1);
+    frontier.clear();
+    wakeRequests.clear();
+    Nsleeping = 0;
+    sleepCounter = 0;
+    cluster.assign(Nblocks, -1);
+    clusterCooldown.assign(Nblocks, 0);
+    cluster_rx.assign(Nblocks, 0.0);
+    cluster_ry.assign(Nblocks, 0.0);
+    cluster_c.assign(Nblocks, 1.0);
+    cluster_s.assign(Nblocks, 0.0);
+    clusterCounter = 0;
+    for (int j = 0; j < grid.Ny; j++) {
+      for (int i = 0; i < grid.Nx; i++) {
+	int block = grid.blockIDs[grid.Nx*j+i];
+	if (block < 0) continue;
+	if (i > 0)           bonds[4*block+0] = grid.blockIDs[grid.Nx*j+i-1];
+	if (i < (grid.Nx-1)) bonds[4*block+1] = grid.blockIDs[grid.Nx*j+i+1];
+	if (j > 0)           bonds[4*block+2] = grid.blockIDs[grid.Nx*(j-1)+i];
+	if (j < (grid.Ny-1)) bonds[4*block+3] = grid.blockIDs[grid.Nx*(j+1)+i];
+      } // for i = ...
+    } // for j = ...
   } // initialize()
 
+  // the cohesive face between blocks i and j has failed: both blocks become fragment blocks, and the pair
+  // is henceforth handled by block-to-block contact
+  void breakBond(int i, int j) {
+    for (int k = 0; k < 4; k++) {
+      if (bonds[4*i+k] == j) bonds[4*i+k] = -1;
+      if (bonds[4*j+k] == i) bonds[4*j+k] = -1;
+    } // for k = ...
+    if (!fragment[i]) { fragment[i] = 1; Nfragments++; }
+    if (!fragment[j]) { fragment[j] = 1; Nfragments++; }
+    verletStale = true;
+  } // breakBond()
+
+  bool bonded(int i, int j) {
+    return (bonds[4*i+0] == j) || (bonds[4*i+1] == j) || (bonds[4*i+2] == j) || (bonds[4*i+3] == j);
+  } // bonded()
+
+  // add a free body (player, projectile, debris) of size L, which interacts with the blocks through contact only
+  int addBody(Material* material, Scalar bodyMass, Scalar x, Scalar y, Scalar velx = 0.0, Scalar vely = 0.0) {
+    body_mat.push_back(material);
+    body_mass.push_back(bodyMass);
+    body_px.push_back(x);
+    body_py.push_back(y);
+    body_vx.push_back(velx);
+    body_vy.push_back(vely);
+    body_fx.push_back(0.0);
+    body_fy.push_back(0.0);
+    return Nbodies++;
+  } // addBody()
+
   void zeroForces() {
     std::fill(fx.begin(), fx.end(), 0.0);
     std::fill(fy.begin(), fy.end(), 0.0);
     std::fill(mz.begin(), mz.end(), 0.0);
-    player_fx = 0.0;
-    player_fy = 0.0;
+    std::fill(body_fx.begin(), body_fx.end(), 0.0);
+    std::fill(body_fy.begin(), body_fy.end(), 0.0);
   } // zeroForces()
 
-  void applyIncrementalDisplacements(float ux, float uy, float dt) {
-    float duxdt = ux / dt;
-    float duydt = uy / dt;
-    for (int i = 0; i < Nblocks; i++) {
-      if (fixity[i] == 0.0) {
-	px[i] += ux;
-	py[i] += uy;
-	vx[i] = duxdt;
-	vy[i] = duydt;
-      } // if (fixity[i] == 0.0)
+  // move the boundary blocks with the ground (by the increments of a substep, at the ground velocity)
+  void applyIncrementalDisplacements(Scalar ux, Scalar uy, Scalar groundVX, Scalar groundVY) {
+    for (int i : boundary) {
+      px[i] += ux;
+      py[i] += uy;
+      vx[i] = groundVX;
+      vy[i] = groundVY;
     } // for i = ...
-  } // applyBodyForce()
+  } // applyIncrementalDisplacements()
 
-  void applyBodyForce(float bx, float by) {
+  void applyBodyForce(Scalar bx, Scalar by) {
     for (int i = 0; i < Nblocks; i++) {
       fx[i] += mass[i] * bx;
       fy[i] += mass[i] * by;
     } // for i = ...
 
-    // apply body force to player
-    if (player_mat != nullptr) {
-      player_fx += player_mass * bx;
-      player_fy += player_mass * by;
-    } // if (player_mat != nullptr)
+    // apply body force to free bodies
+    for (int b = 0; b < Nbodies; b++) {
+      body_fx[b] += body_mass[b] * bx;
+      body_fy[b] += body_mass[b] * by;
+    } // for b = ...
   } // applyBodyForce()
 
   void applyContactForces(void) {
-    // apply contact force to player
-    if (player_mat != nullptr) {
-      float halfL = 0.51*L;
-      float halfB = 0.5*L;
-      float maxContactDistanceSquared = 2.0*L*L;
-      float contactStiffness = 1.0e+4;
-      float contactViscosity = 1.0e+3;
-      float nodex = 0.0;
-      float nodey = 0.0;
-      float fcx = 0.0;
-      float fcy = 0.0;
-      for (int i = 0; i < Nblocks; i++) {
-	float distX = player_px - px[i];
-	float distY = player_py - py[i];
-	if ((distX*distX+distY*distY) < maxContactDistanceSquared) {
-	  float s = sin(rz[i]);
-	  float c = cos(rz[i]);
-	  float drx = (c-s)*halfB;
-	  float dry = (c+s)*halfB;
-
-	  nodex = px[i]-drx;
-	  nodey = py[i]-dry;
-	  distX = player_px - nodex;
-	  distY = player_py - nodey;
-	  if ((fabs(distX) < halfL) && (fabs(distY) < halfL)) {
-	    if (fabs(distX) > fabs(distY)) {
-	      if (distX > 0.0) {
-		// contact on left player face
-		fcx = -contactStiffness*(distX-halfL);
-		fcy = 0.0;
-	      } else {
-		// contact on right player face
-		fcx = -contactStiffness*(distX+halfL);
-		fcy = 0.0;
-	      }
-	    } else {
-	      if (distY > 0.0) {
-		// contact on bottom player face
-		fcy = 0.0;
-		fcx = -contactStiffness*(distY-halfL);
-	      } else {
-		// contact on top player face
-		fcy = 0.0;
-		fcx = -contactStiffness*(distY+halfL);
-	      }
-	    }
-	  } else {
-	    fcx = 0.0;
-	    fcy = 0.0;
-	  } // if ((fabs(distX) < halfL) && (fabs(distY) < halfL))
-	  fx[i] -= fcx;
-	  fy[i] -= fcy;
-	  player_fx += fcx;
-	  player_fy += fcy;
-
-	  nodex = px[i]+dry;
-	  nodey = py[i]-drx;
-	  distX = player_px - nodex;
-	  distY = player_py - nodey;
-	  if ((fabs(distX) < halfL) && (fabs(distY) < halfL)) {
-	    if (fabs(distX) > fabs(distY)) {
-	      if (distX > 0.0) {
-		// contact on left player face
-		fcx = -contactStiffness*(distX-halfL);
-		fcy = 0.0;
-	      } else {
-		// contact on right player face
-		fcx = -contactStiffness*(distX+halfL);
-		fcy = 0.0;
-	      }
-	    } else {
-	      if (distY > 0.0) {
-		// contact on bottom player face
-		fcy = 0.0;
-		fcx = -contactStiffness*(distY-halfL);
-	      } else {
-		// contact on top player face
-		fcy = 0.0;
-		fcx = -contactStiffness*(distY+halfL);
-	      }
-	    }
-	  } else {
-	    fcx = 0.0;
-	    fcy = 0.0;
-	  } // if ((fabs(distX) < halfL) && (fabs(distY) < halfL))
-	  fx[i] -= fcx;
-	  fy[i] -= fcy;
-	  player_fx += fcx;
-	  player_fy += fcy;
-
-	  nodex = px[i]+drx;
-	  nodey = py[i]+dry;
-	  distX = player_px - nodex;
-	  distY = player_py - nodey;
-	  if ((fabs(distX) < halfL) && (fabs(distY) < halfL)) {
-	    if (fabs(distX) > fabs(distY)) {
-	      if (distX > 0.0) {
-		// contact on left player face
-		fcx = -contactStiffness*(distX-halfL);
-		fcy = 0.0;
-	      } else {
-		// contact on right player face
-		fcx = -contactStiffness*(distX+halfL);
-		fcy = 0.0;
-	      }
-	    } else {
-	      if (distY > 0.0) {
-		// contact on bottom player face
-		fcy = 0.0;
-		fcx = -contactStiffness*(distY-halfL);
-	      } else {
-		// contact on top player face
-		fcy = 0.0;
-		fcx = -contactStiffness*(distY+halfL);
-	      }
-	    }
-	  } else {
-	    fcx = 0.0;
-	    fcy = 0.0;
-	  } // if ((fabs(distX) < halfL) && (fabs(distY) < halfL))
-	  fx[i] -= fcx;
-	  fy[i] -= fcy;
-	  player_fx += fcx;
-	  player_fy += fcy;
-
-	  nodex = px[i]-dry;
-	  nodey = py[i]+drx;
-	  distX = player_px - nodex;
-	  distY = player_py - nodey;
-	  if ((fabs(distX) < halfL) && (fabs(distY) < halfL)) {
-	    if (fabs(distX) > fabs(distY)) {
-	      if (distX > 0.0) {
-		// contact on left player face
-		fcx = -contactStiffness*(distX-halfL);
-		fcy = 0.0;
-	      } else {
-		// contact on right player face
-		fcx = -contactStiffness*(distX+halfL);
-		fcy = 0.0;
-	      }
-	    } else {
-	      if (distY > 0.0) {
-		// contact on bottom player face
-		fcy = 0.0;
-		fcx = -contactStiffness*(distY-halfL);
-	      } else {
-		// contact on top player face
-		fcy = 0.0;
-		fcx = -contactStiffness*(distY+halfL);
-	      }
-	    }
-	  } else {
-	    fcx = 0.0;
-	    fcy = 0.0;
-	  } // if ((fabs(distX) < halfL) && (fabs(distY) < halfL))
-	  fx[i] -= fcx;
-	  fy[i] -= fcy;
-	  player_fx += fcx;
-	  player_fy += fcy;
-	  
-	} // if ((distX*distX+distY*distY) < maxContactDistanceSquared)
+    applyFragmentContactForces();
+    if (Nbodies == 0) return;
+    updateBroadphase();
+
+    // apply contact forces between each free body and the blocks near it: block centers within
+    // sqrt(2)*L of the body center lie at most two cells away from the cell of the body center
+    Scalar maxContactDistanceSquared = 2.0*L*L;
+    for (int b = 0; b < Nbodies; b++) {
+      candidates.clear();
+      broadphase.query(body_px[b], body_py[b], 2, [&](int i) {
+	Scalar distX = body_px[b] - px[i];
+	Scalar distY = body_py[b] - py[i];
+	if ((distX*distX+distY*distY) < maxContactDistanceSquared) candidates.push_back(i);
+      });
+      // (visit the blocks in index order, so that the forces are summed in a fixed order)
+      std::sort(candidates.begin(), candidates.end());
+      bool moving = (body_vx[b]*body_vx[b] + body_vy[b]*body_vy[b]) > (sleepVelocity*sleepVelocity);
+      for (int i : candidates) {
+	if (sleeping && moving && asleep[i]) wakeRequests.push_back(i);
+	applyContactForce(b, i);
       } // for i = ...
-    } // if (player_mat != nullptr)
+    } // for b = ...
   } // applyContactForces()
 
-  void applyAcceleration(float ax, float ay) {
+  // update the broadphase (blocks only change buckets when their center leaves its cell)
+  void updateBroadphase(void) {
+    if (broadphaseStale || (broadphase.size() != Nblocks)) {
+      broadphase.initialize(L, px, py);
+      broadphaseStale = false;
+    } else {
+      broadphase.update(px, py);
+    }
+  } // updateBroadphase()
+
+  // contact between blocks that are not bonded to each other, of which at least one is a fragment block
+  // (it has lost at least one cohesive face). The candidate pairs are kept in a Verlet list: all pairs whose
+  // centers lie within the contact range sqrt(2)*L plus a skin distance, rebuilt only once a block has moved
+  // by more than half the skin since the last rebuild (or once further bonds have failed)
+  void applyFragmentContactForces(void) {
+    if (Nfragments == 0) return;
+
+    // check whether the Verlet list is still valid
+    if (!verletStale) {
+      Scalar maxDisplacementSquared = 0.25*skin*skin;
+      for (int i = 0; i < Nblocks; i++) {
+	Scalar dx = px[i] - verletX[i];
+	Scalar dy = py[i] - verletY[i];
+	if ((dx*dx+dy*dy) > maxDisplacementSquared) {
+	  verletStale = true;
+	  break;
+	}
+      } // for i = ...
+    } // if (!verletStale)
+    if (verletStale) buildFragmentPairs();
+
+    for (auto pair : fragmentPairs) {
+      // (resting contact between sleeping blocks is skipped; a moving block wakes a sleeping block it touches)
+      if (sleeping && (asleep[pair.first] || asleep[pair.second])) {
+	if (asleep[pair.first] && asleep[pair.second]) continue;
+	int other = asleep[pair.first] ? pair.second : pair.first;
+	if ((fixity[other] != 0.0) && (quietSteps[other] == 0)) wakeRequests.push_back(asleep[pair.first] ? pair.first : pair.second);
+      }
+      Scalar distX = px[pair.second] - px[pair.first];
+      Scalar distY = py[pair.second] - py[pair.first];
+      if ((distX*distX+distY*distY) < 2.0*L*L) {
+	applyBlockContact(pair.first, pair.second);
+	applyBlockContact(pair.second, pair.first);
+      } // if (within contact range)
+    } // for pair = ...
+  } // applyFragmentContactForces()
+
+  void buildFragmentPairs(void) {
+    updateBroadphase();
+    Scalar range = sqrt(2.0)*L + skin;
+    Scalar rangeSquared = range*range;
+    int cells = int(ceil(range/L));
+    fragmentPairs.clear();
+    for (int i = 0; i < Nblocks; i++) {
+      if (!fragment[i]) continue;
+      broadphase.query(px[i], py[i], cells, [&](int j) {
+	// (pairs of two fragment blocks are only listed once)
+	if ((j == i) || (fragment[j] && (j < i)) || bonded(i,j)) return;
+	Scalar distX = px[j] - px[i];
+	Scalar distY = py[j] - py[i];
+	if ((distX*distX+distY*distY) < rangeSquared) fragmentPairs.push_back(std::pair<int,int>(std::min(i,j),std::max(i,j)));
+      });
+    } // for i = ...
+    std::sort(fragmentPairs.begin(), fragmentPairs.end());
+    verletX = px;
+    verletY = py;
+    verletStale = false;
+  } // buildFragmentPairs()
+
+  // penalty contact between the four corners of block j and the square of block i
+  void applyBlockContact(int i, int j) {
+    Scalar halfB = 0.5*L;
+    Scalar s = sz[j];
+    Scalar c = cz[j];
+    Scalar drx = (c-s)*halfB;
+    Scalar dry = (c+s)*halfB;
+    applyBlockCornerContact(i, j, px[j]-drx, py[j]-dry);
+    applyBlockCornerContact(i, j, px[j]+dry, py[j]-drx);
+    applyBlockCornerContact(i, j, px[j]+drx, py[j]+dry);
+    applyBlockCornerContact(i, j, px[j]-dry, py[j]+drx);
+  } // applyBlockContact()
+
+  // push the corner (nodex,nodey) of block j out of block i, along the normal of the nearest face of block i
+  inline void applyBlockCornerContact(int i, int j, Scalar nodex, Scalar nodey) {
+    Scalar halfB = 0.5*L;
+
+    // corner position relative to both block centers, and in the coordinate system of block i
+    Scalar rix = nodex - px[i];
+    Scalar riy = nodey - py[i];
+    Scalar rjx = nodex - px[j];
+    Scalar rjy = nodey - py[j];
+    Scalar localX = + cz[i]*rix + sz[i]*riy;
+    Scalar localY = - sz[i]*rix + cz[i]*riy;
+    if ((fabs(localX) >= halfB) || (fabs(localY) >= halfB)) return;
+
+    // outward normal and penetration depth
+    Scalar nx, ny, depth;
+    if (fabs(localX) > fabs(localY)) {
+      Scalar sign = (localX > 0.0) ? 1.0 : -1.0;
+      nx = sign*cz[i];
+      ny = sign*sz[i];
+      depth = halfB - fabs(localX);
+    } else {
+      Scalar sign = (localY > 0.0) ? 1.0 : -1.0;
+      nx = -sign*sz[i];
+      ny = sign*cz[i];
+      depth = halfB - fabs(localY);
+    }
+
+    // normal velocity of the corner of block j relative to block i
+    Scalar vn = (vx[j] - wz[j]*rjy - vx[i] + wz[i]*riy)*nx + (vy[j] + wz[j]*rjx - vy[i] - wz[i]*rix)*ny;
+
+    // compressive penalty force (with viscous damping) applied to block j, and its reaction on block i
+    Scalar fn = std::max(Scalar(0.0), contactStiffness*depth - contactViscosity*vn);
+    Scalar fcx = fn*nx;
+    Scalar fcy = fn*ny;
+    fx[j] += fcx;
+    fy[j] += fcy;
+    mz[j] += rjx*fcy - rjy*fcx;
+    fx[i] -= fcx;
+    fy[i] -= fcy;
+    mz[i] -= rix*fcy - riy*fcx;
+  } // applyBlockCornerContact()
+
+  // contact between the square free body b and the four corners of block i
+  void applyContactForce(int b, int i) {
+    Scalar halfB = 0.5*L;
+    Scalar s = sz[i];
+    Scalar c = cz[i];
+    Scalar drx = (c-s)*halfB;
+    Scalar dry = (c+s)*halfB;
+    applyCornerContact(b, i, px[i]-drx, py[i]-dry);
+    applyCornerContact(b, i, px[i]+dry, py[i]-drx);
+    applyCornerContact(b, i, px[i]+drx, py[i]+dry);
+    applyCornerContact(b, i, px[i]-dry, py[i]+drx);
+  } // applyContactForce()
+
+  // penalty contact force between the corner (nodex,nodey) of block i and the faces of free body b
+  inline void applyCornerContact(int b, int i, Scalar nodex, Scalar nodey) {
+    Scalar halfL = 0.51*L;
+    Scalar distX = body_px[b] - nodex;
+    Scalar distY = body_py[b] - nodey;
+    Scalar fcx = 0.0;
+    Scalar fcy = 0.0;
+    if ((fabs(distX) < halfL) && (fabs(distY) < halfL)) {
+      if (fabs(distX) > fabs(distY)) {
+	if (distX > 0.0) {
+	  // contact on left body face
+	  fcx = -contactStiffness*(distX-halfL);
+	} else {
+	  // contact on right body face
+	  fcx = -contactStiffness*(distX+halfL);
+	}
+      } else {
+	if (distY > 0.0) {
+	  // contact on bottom body face
+	  fcy = -contactStiffness*(distY-halfL);
+	} else {
+	  // contact on top body face
+	  fcy = -contactStiffness*(distY+halfL);
+	}
+      }
+    } // if ((fabs(distX) < halfL) && (fabs(distY) < halfL))
+    fx[i] -= fcx;
+    fy[i] -= fcy;
+    body_fx[b] += fcx;
+    body_fy[b] += fcy;
+  } // applyCornerContact()
+
+  void applyAcceleration(Scalar ax, Scalar ay) {
     for (int i = 0; i < Nblocks; i++) {
       fx[i] += ax;
       fy[i] += ay;
     } // for i = ...
 
-    // apply acceleration to player
-    if (player_mat != nullptr) {
-      player_fx += ax;
-      player_fy += ay;
-    } // if (player_mat != nullptr)
+    // apply acceleration to free bodies
+    for (int b = 0; b < Nbodies; b++) {
+      body_fx[b] += ax;
+      body_fy[b] += ay;
+    } // for b = ...
   } // applyAcceleration()
 
-  void applyDragForce(float drag_coefficient) {
+  void applyDragForce(Scalar drag_coefficient) {
     for (int i = 0; i < Nblocks; i++) {
-      float drag_force = drag_coefficient * (vx[i]*vx[i] + vy[i]*vy[i]);
-      float drag_moment = drag_coefficient * (wz[i]*wz[i]);
+      Scalar drag_force = drag_coefficient * (vx[i]*vx[i] + vy[i]*vy[i]);
+      Scalar drag_moment = drag_coefficient * (wz[i]*wz[i]);
       fx[i] -= drag_force * vx[i];
       fy[i] -= drag_force * vy[i];
       mz[i] -= drag_moment * wz[i];
     } // for i = ...
 
-    // apply drag to player
-    if (player_mat != nullptr) {
-      float drag_force = drag_coefficient * (player_vx*player_vx + player_vy*player_vy);
-      player_fx -= drag_force * player_vx;
-      player_fy -= drag_force * player_vy;
-    } // if (player_mat != nullptr)
+    // apply drag to free bodies
+    for (int b = 0; b < Nbodies; b++) {
+      Scalar drag_force = drag_coefficient * (body_vx[b]*body_vx[b] + body_vy[b]*body_vy[b]);
+      body_fx[b] -= drag_force * body_vx[b];
+      body_fy[b] -= drag_force * body_vy[b];
+    } // for b = ...
   } // applyDragForce()
 
-  void timeIntegrate(float dt) {
-    // integrate block positions in time
-    for (int i = 0; i < Nblocks; i++) {
+  // fused substep update: integrate the block positions in time, then set the forces of the next substep
+  // to its external loads (body force and drag), replacing the separate zeroForces, applyBodyForce and
+  // applyDragForce passes. The blocks are processed in slices on the thread pool (if any)
+  //
+  // multi-rate stepping: dt is the substep of the finest level, and a block of level l takes its step of
+  // 2^(finestLevel-l) substeps at every multiple of that many substeps; in between it drifts with its velocity
+  // at every substep, so that the finer faces it shares see its motion interpolated linearly over the coarse
+  // step. Its forces are summed over the substeps since its last step (only the external loads are added on
+  // the substeps without a step), and each face force is weighted by the substeps of its own level (see
+  // CohesiveZone::levelWeight), so that the two blocks of a face receive equal and opposite impulses
+  void timeIntegrate(Scalar dt, Scalar bx, Scalar by, Scalar drag_coefficient, int substep = 0) {
+    if (Nclusters > 0) integrateClusters(dt);
+    forEachSlice([&](int begin, int end) {
+      if (finestLevel > 0) {
+	if (drag_coefficient == 0.0) {
+	  integrateSlice<false,true>(begin, end, dt, bx, by, drag_coefficient, substep);
+	} else {
+	  integrateSlice<true,true>(begin, end, dt, bx, by, drag_coefficient, substep);
+	}
+      } else if (drag_coefficient == 0.0) {
+	integrateSlice<false>(begin, end, dt, bx, by, drag_coefficient);
+      } else {
+	integrateSlice<true>(begin, end, dt, bx, by, drag_coefficient);
+      }
+    });
+    for (int b = 0; b < Nbodies; b++) {
+      body_vx[b] += dt * body_fx[b] / body_mass[b];
+      body_vy[b] += dt * body_fy[b] / body_mass[b];
+      body_px[b] += dt * body_vx[b];
+      body_py[b] += dt * body_vy[b];
+      setBodyLoads(b, bx, by, drag_coefficient);
+    } // for b = ...
+  } // timeIntegrate()
+
+  // implicit substep update: apply the velocity increments dv (x, y and rotation of each block) solved for by
+  // the implicit integrator, then move the blocks and set the external loads of the next substep as above
+  // (free bodies are still integrated explicitly)
+  void timeIntegrate(Scalar dt, const std::vector<Scalar>& dv, Scalar bx, Scalar by, Scalar drag_coefficient) {
+    forEachSlice([&](int begin, int end) {
+      for (int i = begin; i < end; i++) {
+	if (sleeping && asleep[i]) {
+	  if (drag_coefficient == 0.0) {
+	    setExternalLoads<false>(i, bx, by, drag_coefficient);
+	  } else {
+	    setExternalLoads<true>(i, bx, by, drag_coefficient);
+	  }
+	  continue;
+	}
+	if (sleeping) updateQuiet(i, dv[3*i]/dt, dv[3*i+1]/dt, dv[3*i+2]/dt);
+	vx[i] += dv[3*i];
+	vy[i] += dv[3*i+1];
+	wz[i] += dv[3*i+2];
+	advancePosition(i, dt);
+	if (drag_coefficient == 0.0) {
+	  setExternalLoads<false>(i, bx, by, drag_coefficient);
+	} else {
+	  setExternalLoads<true>(i, bx, by, drag_coefficient);
+	}
+      } // for i = ...
+    });
+    for (int b = 0; b < Nbodies; b++) {
+      body_vx[b] += dt * body_fx[b] / body_mass[b];
+      body_vy[b] += dt * body_fy[b] / body_mass[b];
+      body_px[b] += dt * body_vx[b];
+      body_py[b] += dt * body_vy[b];
+      setBodyLoads(b, bx, by, drag_coefficient);
+    } // for b = ...
+  } // timeIntegrate()
+
+  // set the forces to the external loads of the first substep (the fused update sets those of the following ones)
+  void initializeForces(Scalar bx, Scalar by, Scalar drag_coefficient) {
+    forEachSlice([&](int begin, int end) {
+      for (int i = begin; i < end; i++) {
+	if (drag_coefficient == 0.0) {
+	  setExternalLoads<false>(i, bx, by, drag_coefficient);
+	} else {
+	  setExternalLoads<true>(i, bx, by, drag_coefficient);
+	}
+      } // for i = ...
+    });
+    for (int b = 0; b < Nbodies; b++) setBodyLoads(b, bx, by, drag_coefficient);
+  } // initializeForces()
+
+  template <bool drag, bool multirate = false>
+  void integrateSlice(int begin, int end, Scalar dt, Scalar bx, Scalar by, Scalar drag_coefficient, int substep = 0) {
+    for (int i = begin; i < end; i++) {
+      if ((sleeping && asleep[i]) || (clustering && (cluster[i] >= 0))) {
+	// (clustered blocks have been moved with their cluster)
+	setExternalLoads<drag>(i, bx, by, drag_coefficient);
+	continue;
+      }
+      if (sleeping) updateQuiet(i, fx[i]*imass[i], fy[i]*imass[i], mz[i]*iinertia[i]);
+      if (multirate) {
+	int period = 1 << (finestLevel - level[i]);
+	if (((substep & (period-1)) != 0) && (fixity[i] != 0.0)) {
+	  // (the forces of this substep are kept, and summed with those of the next; fixed blocks, whose motion
+	  // is prescribed, only keep the forces of the current substep for the base force record)
+	  advancePosition(i, dt);
+	  setExternalLoads<drag,true>(i, bx, by, drag_coefficient);
+	  continue;
+	}
+      }
       vx[i] += dt * imass[i] * fx[i];
       vy[i] += dt * imass[i] * fy[i];
       wz[i] += dt * iinertia[i] * mz[i];
-      vx[i] *= fixity[i];
-      vy[i] *= fixity[i];
-      wz[i] *= fixity[i];
-      px[i] += dt * vx[i];
-      py[i] += dt * vy[i];
-      rz[i] += dt * wz[i];
+      advancePosition(i, dt);
+      setExternalLoads<drag>(i, bx, by, drag_coefficient);
     } // for i = ...
+  } // integrateSlice()
 
-    // integrate player position in time
-    if (player_mat != nullptr) {
-      player_vx += dt * player_fx / player_mass;
-      player_vy += dt * player_fy / player_mass;
-      player_px += dt * player_vx;
-      player_py += dt * player_vy;
-    } // if (player_mat != nullptr)
-  } // timeIntegrate()
+  // count the substeps for which block i has remained at rest (its velocity and acceleration within the sleep thresholds)
+  inline void updateQuiet(int i, Scalar ax, Scalar ay, Scalar az) {
+    Scalar v2 = vx[i]*vx[i] + vy[i]*vy[i] + (wz[i]*L)*(wz[i]*L);
+    Scalar a2 = ax*ax + ay*ay + (az*L)*(az*L);
+    bool quiet = (v2 < sleepVelocity*sleepVelocity) && (a2 < sleepAcceleration*sleepAcceleration);
+    quietSteps[i] = quiet ? quietSteps[i]+1 : 0;
+  } // updateQuiet()
+
+  // sleeping: the free blocks are grouped into islands, connected by their intact cohesive faces (fixed blocks do not
+  // join islands). An island falls asleep once all of its blocks have remained at rest for sleepSteps substeps: its
+  // velocities are zeroed, and it is skipped by the face passes and the block update until it is woken. Returns
+  // true if any island has fallen asleep (the face lists must then be re-sorted)
+  bool updateSleepStates(void) {
+    // find the islands (union-find over the bonds between free blocks)
+    findFragments(island);
+
+    // list the blocks of each island
+    islandStart.assign(Nblocks+1, 0);
+    for (int i = 0; i < Nblocks; i++) if (island[i] >= 0) islandStart[island[i]+1]++;
+    for (int i = 0; i < Nblocks; i++) islandStart[i+1] += islandStart[i];
+    islandBlocks.resize(islandStart[Nblocks]);
+    std::vector<int> next(islandStart.begin(), islandStart.end()-1);
+    for (int i = 0; i < Nblocks; i++) if (island[i] >= 0) islandBlocks[next[island[i]]++] = i;
+
+    // put the islands to sleep whose blocks have all been at rest for long enough
+    bool changed = false;
+    for (int r = 0; r < Nblocks; r++) {
+      if ((islandStart[r] == islandStart[r+1]) || asleep[islandBlocks[islandStart[r]]]) continue;
+      bool quiet = true;
+      for (int k = islandStart[r]; quiet && (k < islandStart[r+1]); k++) quiet = (quietSteps[islandBlocks[k]] >= sleepSteps);
+      if (!quiet) continue;
+      for (int k = islandStart[r]; k < islandStart[r+1]; k++) {
+	int i = islandBlocks[k];
+	asleep[i] = 1;
+	vx[i] = 0.0;
+	vy[i] = 0.0;
+	wz[i] = 0.0;
+	Nsleeping++;
+      } // for k = ...
+      changed = true;
+    } // for r = ...
+
+    // the awake (or fixed) blocks bonded to a sleeping block may wake it
+    frontier.clear();
+    for (int i = 0; i < Nblocks; i++) {
+      if (asleep[i]) continue;
+      for (int k = 0; k < 4; k++) {
+	int j = bonds[4*i+k];
+	if ((j >= 0) && asleep[j]) {
+	  frontier.push_back(i);
+	  break;
+	}
+      } // for k = ...
+    } // for i = ...
+    return changed;
+  } // updateSleepStates()
+
+  // label the connected components of the free blocks over their intact bonds (fixed blocks do not connect
+  // components): component[i] is the smallest block index of the component of block i (-1: fixed block)
+  void findFragments(std::vector<int>& component) {
+    component.resize(Nblocks);
+    for (int i = 0; i < Nblocks; i++) component[i] = (fixity[i] != 0.0) ? i : -1;
+    for (int i = 0; i < Nblocks; i++) {
+      if (fixity[i] == 0.0) continue;
+      for (int k = 0; k < 4; k++) {
+	int j = bonds[4*i+k];
+	if ((j >= 0) && (fixity[j] != 0.0)) join(component, i, j);
+      } // for k = ...
+    } // for i = ...
+    for (int i = 0; i < Nblocks; i++) if (component[i] >= 0) component[i] = root(component, i);
+  } // findFragments()
+
+  // union-find over a parent array (each root being the smallest index of its set)
+  static int root(std::vector<int>& parent, int i) {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    } // while (parent[i] != i)
+    return i;
+  } // root()
 
+  static void join(std::vector<int>& parent, int i, int j) {
+    int ri = root(parent, i);
+    int rj = root(parent, j);
+    if (ri != rj) parent[std::max(ri,rj)] = std::min(ri,rj);
+  } // join()
+
+  // number and sizes of the fragments: the pieces of the free blocks still joined by intact cohesive faces
+  struct FragmentStatistics {
+    int count = 0;         // number of fragments
+    int largest = 0;       // blocks in the largest fragment
+    int single = 0;        // fragments of a single block (debris)
+    Scalar meanSize = 0.0;  // mean number of blocks per fragment
+  }; // FragmentStatistics
+
+  FragmentStatistics fragmentStatistics(void) {
+    FragmentStatistics statistics;
+    std::vector<int> component;
+    findFragments(component);
+    std::vector<int> size(Nblocks, 0);
+    int Nfree = 0;
+    for (int i = 0; i < Nblocks; i++) {
+      if (component[i] < 0) continue;
+      size[component[i]]++;
+      Nfree++;
+    } // for i = ...
+    for (int n : size) {
+      if (n == 0) continue;
+      statistics.count++;
+      statistics.largest = std::max(statistics.largest, n);
+      if (n == 1) statistics.single++;
+    } // for n = ...
+    if (statistics.count > 0) statistics.meanSize = Scalar(Nfree)/statistics.count;
+    return statistics;
+  } // fragmentStatistics()
+
+  // update the sleep states at the start of a substep: wake the disturbed islands, and every sleepInterval substeps
+  // put the islands at rest to sleep. Returns true if any block has changed state
+  bool updateSleeping(void) {
+    bool changed = wakeIslands();
+    if (++sleepCounter >= sleepInterval) {
+      sleepCounter = 0;
+      changed = updateSleepStates() || changed;
+    }
+    return changed;
+  } // updateSleeping()
+
+  // wake the islands disturbed since the last substep: by a moving block bonded to them (or by the prescribed
+  // motion of a fixed block), or by contact with a moving block or free body. Returns true if any island has woken
+  // (the face lists must then be re-sorted)
+  bool wakeIslands(void) {
+    for (int i : frontier) {
+      if (asleep[i]) continue;
+      bool moving = (fixity[i] == 0.0) ? ((vx[i]*vx[i] + vy[i]*vy[i]) > (sleepVelocity*sleepVelocity)) : (quietSteps[i] == 0);
+      if (!moving) continue;
+      for (int k = 0; k < 4; k++) {
+	int j = bonds[4*i+k];
+	if ((j >= 0) && asleep[j]) wakeRequests.push_back(j);
+      } // for k = ...
+    } // for i = ...
+
+    bool changed = false;
+    for (int j : wakeRequests) {
+      if (!asleep[j]) continue;
+      for (int k = islandStart[island[j]]; k < islandStart[island[j]+1]; k++) {
+	int i = islandBlocks[k];
+	asleep[i] = 0;
+	quietSteps[i] = 0;
+	Nsleeping--;
+      } // for k = ...
+      changed = true;
+    } // for j = ...
+    wakeRequests.clear();
+    return changed;
+  } // wakeIslands()
+
+  // rigid clusters: groups of free blocks joined by faces still in the elastic regime are simulated as single
+  // rigid bodies, with the mass and inertia aggregated from their blocks (each block keeping its offset and
+  // orientation in the frame of its cluster), and the faces inside a cluster are skipped by the face passes.
+  // A cluster is split back into its blocks once the force its faces must transmit to one of its blocks (the
+  // part of the force on the block not carried by the rigid motion) nears the strength of its weakest face
+
+  // form clusters from the connected components of the given elastic faces (with the force capacity of each),
+  // among the free, awake blocks that are not part of (or have just left) a cluster; returns true if any has formed
+  bool formClusters(const std::vector<std::pair<int,int> >& pairs, const std::vector<Scalar>& strengths) {
+    for (int i = 0; i < Nblocks; i++) if (clusterCooldown[i] > 0) clusterCooldown[i]--;
+    auto available = [&](int i) { return (fixity[i] != 0.0) && (cluster[i] < 0) && (clusterCooldown[i] == 0) && !(sleeping && asleep[i]); };
+    std::vector<int> component(Nblocks);
+    for (int i = 0; i < Nblocks; i++) component[i] = i;
+    for (auto pair : pairs) {
+      if (available(pair.first) && available(pair.second)) join(component, pair.first, pair.second);
+    } // for pair = ...
+    std::vector<Scalar> strength(Nblocks, std::numeric_limits<Scalar>::max());
+    for (int k = 0; k < int(pairs.size()); k++) {
+      if (!available(pairs[k].first) || !available(pairs[k].second)) continue;
+      int r = root(component, pairs[k].first);
+      strength[r] = std::min(strength[r], strengths[k]);
+    } // for k = ...
+    std::vector<int> size(Nblocks, 0);
+    for (int i = 0; i < Nblocks; i++) {
+      component[i] = root(component, i);
+      size[component[i]]++;
+    } // for i = ...
+
+    // every component of two or more blocks becomes a cluster
+    bool formed = false;
+    std::vector<int> id(Nblocks, -1);
+    for (int i = 0; i < Nblocks; i++) {
+      int r = component[i];
+      if (size[r] < 2) continue;
+      if (id[r] < 0) {
+	id[r] = Nclusters++;
+	cluster_strength.push_back(strength[r]);
+	formed = true;
+      }
+      cluster[i] = id[r];
+    } // for i = ...
+    if (!formed) return false;
+    indexClusters();
+
+    // aggregate the mass, inertia and momentum of the new clusters
+    int Nold = cluster_mass.size();
+    cluster_mass.resize(Nclusters);
+    cluster_iinertia.resize(Nclusters);
+    cluster_px.resize(Nclusters);
+    cluster_py.resize(Nclusters);
+    cluster_cz.resize(Nclusters);
+    cluster_sz.resize(Nclusters);
+    cluster_vx.resize(Nclusters);
+    cluster_vy.resize(Nclusters);
+    cluster_wz.resize(Nclusters);
+    for (int c = Nold; c < Nclusters; c++) {
+      double M = 0.0, X = 0.0, Y = 0.0, Px = 0.0, Py = 0.0;
+      for (int k = clusterStart[c]; k < clusterStart[c+1]; k++) {
+	int i = clusterBlocks[k];
+	M  += mass[i];
+	X  += mass[i]*px[i];
+	Y  += mass[i]*py[i];
+	Px += mass[i]*vx[i];
+	Py += mass[i]*vy[i];
+      } // for k = ...
+      X /= M;
+      Y /= M;
+      double I = 0.0, H = 0.0;
+      for (int k = clusterStart[c]; k < clusterStart[c+1]; k++) {
+	int i = clusterBlocks[k];
+	double rx = px[i] - X;
+	double ry = py[i] - Y;
+	I += 1.0/iinertia[i] + mass[i]*(rx*rx + ry*ry);
+	H += wz[i]/iinertia[i] + mass[i]*(rx*vy[i] - ry*vx[i]);
+	cluster_rx[i] = rx;
+	cluster_ry[i] = ry;
+	cluster_c[i] = cz[i];
+	cluster_s[i] = sz[i];
+      } // for k = ...
+      cluster_mass[c] = M;
+      cluster_iinertia[c] = 1.0/I;
+      cluster_px[c] = X;
+      cluster_py[c] = Y;
+      cluster_cz[c] = 1.0;
+      cluster_sz[c] = 0.0;
+      cluster_vx[c] = Px/M;
+      cluster_vy[c] = Py/M;
+      cluster_wz[c] = H/I;
+      placeClusterBlocks(c);
+    } // for c = ...
+    return true;
+  } // formClusters()
+
+  // split the clusters flagged during the last update back into their blocks (which then stay out of
+  // clusters for clusterCooldown substeps); returns true if any cluster has been split
+  bool splitClusters(void) {
+    if (!pendingSplit) return false;
+    pendingSplit = false;
+    std::vector<int> id(Nclusters, -1);
+    int Nkept = 0;
+    for (int c = 0; c < Nclusters; c++) {
+      if (cluster_split[c]) continue;
+      id[c] = Nkept;
+      cluster_mass[Nkept]       = cluster_mass[c];
+      cluster_iinertia[Nkept]   = cluster_iinertia[c];
+      cluster_strength[Nkept]   = cluster_strength[c];
+      cluster_px[Nkept]         = cluster_px[c];
+      cluster_py[Nkept]         = cluster_py[c];
+      cluster_cz[Nkept]         = cluster_cz[c];
+      cluster_sz[Nkept]         = cluster_sz[c];
+      cluster_vx[Nkept]         = cluster_vx[c];
+      cluster_vy[Nkept]         = cluster_vy[c];
+      cluster_wz[Nkept]         = cluster_wz[c];
+      Nkept++;
+    } // for c = ...
+    for (int i = 0; i < Nblocks; i++) {
+      if (cluster[i] < 0) continue;
+      if (id[cluster[i]] < 0) clusterCooldown[i] = clusterCooldownPasses;
+      cluster[i] = id[cluster[i]];
+    } // for i = ...
+    Nclusters = Nkept;
+    cluster_mass.resize(Nclusters);
+    cluster_iinertia.resize(Nclusters);
+    cluster_strength.resize(Nclusters);
+    cluster_px.resize(Nclusters);
+    cluster_py.resize(Nclusters);
+    cluster_cz.resize(Nclusters);
+    cluster_sz.resize(Nclusters);
+    cluster_vx.resize(Nclusters);
+    cluster_vy.resize(Nclusters);
+    cluster_wz.resize(Nclusters);
+    indexClusters();
+    return true;
+  } // splitClusters()
+
+  // dissolve all clusters (e.g. before switching integrators)
+  void clearClusters(void) {
+    if (Nclusters == 0) return;
+    std::fill(cluster_split.begin(), cluster_split.end(), 1);
+    pendingSplit = true;
+    splitClusters();
+  } // clearClusters()
+
+  // list the blocks of each cluster
+  void indexClusters(void) {
+    clusterStart.assign(Nclusters+1, 0);
+    for (int i = 0; i < Nblocks; i++) if (cluster[i] >= 0) clusterStart[cluster[i]+1]++;
+    for (int c = 0; c < Nclusters; c++) clusterStart[c+1] += clusterStart[c];
+    clusterBlocks.resize(clusterStart[Nclusters]);
+    std::vector<int> next(clusterStart.begin(), clusterStart.end()-1);
+    for (int i = 0; i < Nblocks; i++) if (cluster[i] >= 0) clusterBlocks[next[cluster[i]]++] = i;
+    cluster_split.assign(Nclusters, 0);
+  } // indexClusters()
+
+  // integrate the rigid motion of cluster c from the forces on its blocks (flagging it for splitting if
+  // any block needs more than splitFraction of the capacity of the weakest face from its neighbors to
+  // follow the rigid motion), then place its blocks
+  void integrateCluster(int c, Scalar dt) {
+    int first = clusterBlocks[clusterStart[c]];
+    if (sleeping && asleep[first]) {
+      // (sleeping islands contain whole clusters)
+      cluster_vx[c] = 0.0;
+      cluster_vy[c] = 0.0;
+      cluster_wz[c] = 0.0;
+      return;
+    }
+
+    // resultant force and moment about the center of mass
+    Scalar Fx = 0.0, Fy = 0.0, Mz = 0.0;
+    for (int k = clusterStart[c]; k < clusterStart[c+1]; k++) {
+      int i = clusterBlocks[k];
+      Scalar rx = px[i] - cluster_px[c];
+      Scalar ry = py[i] - cluster_py[c];
+      Fx += fx[i];
+      Fy += fy[i];
+      Mz += mz[i] + rx*fy[i] - ry*fx[i];
+    } // for k = ...
+    Scalar ax = Fx / cluster_mass[c];
+    Scalar ay = Fy / cluster_mass[c];
+    Scalar alpha = Mz * cluster_iinertia[c];
+
+    // force that the faces of each block would have to transmit to keep it on the rigid motion
+    Scalar w = cluster_wz[c];
+    Scalar limit = splitFraction*cluster_strength[c];
+    for (int k = clusterStart[c]; k < clusterStart[c+1]; k++) {
+      int i = clusterBlocks[k];
+      Scalar rx = px[i] - cluster_px[c];
+      Scalar ry = py[i] - cluster_py[c];
+      Scalar aix = ax - alpha*ry - w*w*rx;
+      Scalar aiy = ay + alpha*rx - w*w*ry;
+      Scalar gx = mass[i]*aix - fx[i];
+      Scalar gy = mass[i]*aiy - fy[i];
+      if ((gx*gx + gy*gy) > limit*limit) cluster_split[c] = 1;
+      if (sleeping) updateQuiet(i, aix, aiy, alpha);
+    } // for k = ...
+
+    // integrate the rigid motion, as for a single block
+    cluster_vx[c] += dt * ax;
+    cluster_vy[c] += dt * ay;
+    cluster_wz[c] += dt * alpha;
+    cluster_px[c] += dt * cluster_vx[c];
+    cluster_py[c] += dt * cluster_vy[c];
+    Scalar h = 0.5 * dt * cluster_wz[c];
+    Scalar cc = cluster_cz[c]*(1.0f-h*h) - cluster_sz[c]*(2.0f*h);
+    Scalar ss = cluster_sz[c]*(1.0f-h*h) + cluster_cz[c]*(2.0f*h);
+    Scalar inorm = 1.0f / sqrt(cc*cc + ss*ss);
+    cluster_cz[c] = cc * inorm;
+    cluster_sz[c] = ss * inorm;
+    placeClusterBlocks(c);
+  } // integrateCluster()
+
+  // integrate all clusters (in parallel if a thread pool is given), noting whether any must be split
+  void integrateClusters(Scalar dt) {
+    if (pool == nullptr) {
+      for (int c = 0; c < Nclusters; c++) integrateCluster(c, dt);
+    } else {
+      pool->parallelFor(Nclusters, [&](int thread, int c) { integrateCluster(c, dt); });
+    }
+    pendingSplit = std::find(cluster_split.begin(), cluster_split.end(), 1) != cluster_split.end();
+  } // integrateClusters()
+
+  // set the positions, orientations and velocities of the blocks of cluster c from its rigid motion
+  void placeClusterBlocks(int c) {
+    Scalar cc = cluster_cz[c];
+    Scalar ss = cluster_sz[c];
+    Scalar w = cluster_wz[c];
+    for (int k = clusterStart[c]; k < clusterStart[c+1]; k++) {
+      int i = clusterBlocks[k];
+      Scalar rx = cc*cluster_rx[i] - ss*cluster_ry[i];
+      Scalar ry = ss*cluster_rx[i] + cc*cluster_ry[i];
+      px[i] = cluster_px[c] + rx;
+      py[i] = cluster_py[c] + ry;
+      cz[i] = cc*cluster_c[i] - ss*cluster_s[i];
+      sz[i] = ss*cluster_c[i] + cc*cluster_s[i];
+      vx[i] = cluster_vx[c] - w*ry;
+      vy[i] = cluster_vy[c] + w*rx;
+      wz[i] = w;
+    } // for k = ...
+  } // placeClusterBlocks()
+
+  // degrees of freedom of the blocks and clusters currently integrated (3 per free block or cluster)
+  int degreesOfFreedom(void) {
+    int count = Nclusters;
+    for (int i = 0; i < Nblocks; i++) if ((fixity[i] != 0.0) && (cluster[i] < 0)) count++;
+    return 3*count;
+  } // degreesOfFreedom()
+
+  // apply the velocity (or, for fixed blocks, displacement-rate) constraint, then move block i with its velocity
+  inline void advancePosition(int i, Scalar dt) {
+    vx[i] *= fixity[i];
+    vy[i] *= fixity[i];
+    wz[i] *= fixity[i];
+    px[i] += dt * vx[i];
+    py[i] += dt * vy[i];
+
+    // rotate the orientation (cos,sin) by the angle increment dt*wz, using the Cayley
+    // form (1 - h^2, 2h) with h = dt*wz/2, then renormalize to remove any drift
+    Scalar h = 0.5 * dt * wz[i];
+    Scalar c = cz[i]*(1.0f-h*h) - sz[i]*(2.0f*h);
+    Scalar s = sz[i]*(1.0f-h*h) + cz[i]*(2.0f*h);
+    Scalar inorm = 1.0f / sqrt(c*c + s*s);
+    cz[i] = c * inorm;
+    sz[i] = s * inorm;
+  } // advancePosition()
+
+  // equivalent to zeroForces, applyBodyForce and applyDragForce for block i (drag is skipped at compile time if
+  // unused); with add, the loads are added to the forces already held (multi-rate blocks between their steps)
+  template <bool drag, bool add = false>
+  inline void setExternalLoads(int i, Scalar bx, Scalar by, Scalar drag_coefficient) {
+    if (add) {
+      fx[i] += mass[i] * bx;
+      fy[i] += mass[i] * by;
+    } else {
+      fx[i] = mass[i] * bx;
+      fy[i] = mass[i] * by;
+      mz[i] = 0.0;
+    }
+    if (drag) {
+      Scalar drag_force = drag_coefficient * (vx[i]*vx[i] + vy[i]*vy[i]);
+      Scalar drag_moment = drag_coefficient * (wz[i]*wz[i]);
+      fx[i] -= drag_force * vx[i];
+      fy[i] -= drag_force * vy[i];
+      mz[i] -= drag_moment * wz[i];
+    } // if (drag)
+  } // setExternalLoads()
+
+  void setBodyLoads(int b, Scalar bx, Scalar by, Scalar drag_coefficient) {
+    Scalar drag_force = drag_coefficient * (body_vx[b]*body_vx[b] + body_vy[b]*body_vy[b]);
+    body_fx[b] = body_mass[b] * bx - drag_force * body_vx[b];
+    body_fy[b] = body_mass[b] * by - drag_force * body_vy[b];
+  } // setBodyLoads()
+
+  // call task(begin, end) for contiguous slices of blocks, in parallel if a thread pool is attached
+  template <class Task>
+  void forEachSlice(Task task) {
+    if (pool == nullptr) {
+      task(0, Nblocks);
+      return;
+    }
+    int Nslices = (Nblocks + SLICE_SIZE - 1) / SLICE_SIZE;
+    pool->parallelFor(Nslices, [&](int thread, int slice) {
+      task(slice*SLICE_SIZE, std::min(Nblocks, (slice+1)*SLICE_SIZE));
+    });
+  } // forEachSlice()
+
+  Scalar angle(int i) {
+    return atan2(sz[i], cz[i]);
+  } // angle()
+
+  // save or restore the dynamic state of the blocks and bodies (the layout, materials and run options are
+  // not saved: a checkpoint is restored into blocks initialized from the same layout)
+  void checkpoint(Checkpoint& checkpoint) {
+    checkpoint.match(Nblocks);
+    checkpoint.match(Nbodies);
+    checkpoint.array(px);
+    checkpoint.array(py);
+    checkpoint.array(cz);
+    checkpoint.array(sz);
+    checkpoint.array(vx);
+    checkpoint.array(vy);
+    checkpoint.array(wz);
+    checkpoint.array(fx);
+    checkpoint.array(fy);
+    checkpoint.array(mz);
+    checkpoint.array(body_px);
+    checkpoint.array(body_py);
+    checkpoint.array(body_vx);
+    checkpoint.array(body_vy);
+    checkpoint.array(body_fx);
+    checkpoint.array(body_fy);
+    checkpoint.array(level);
+    checkpoint.value(finestLevel);
+
+    // contact
+    checkpoint.value(broadphaseStale);
+    if (!broadphaseStale) broadphase.checkpoint(checkpoint);
+    checkpoint.array(bonds);
+    checkpoint.array(fragment);
+    checkpoint.value(Nfragments);
+    checkpoint.array(fragmentPairs);
+    checkpoint.array(verletX);
+    checkpoint.array(verletY);
+    checkpoint.value(verletStale);
+
+    // sleeping
+    checkpoint.array(asleep);
+    checkpoint.array(quietSteps);
+    checkpoint.array(island);
+    checkpoint.array(islandStart);
+    checkpoint.array(islandBlocks);
+    checkpoint.array(frontier);
+    checkpoint.array(wakeRequests);
+    checkpoint.value(Nsleeping);
+    checkpoint.value(sleepCounter);
+
+    // clusters
+    checkpoint.value(Nclusters);
+    checkpoint.value(clusterCounter);
+    checkpoint.value(pendingSplit);
+    checkpoint.array(cluster);
+    checkpoint.array(clusterCooldown);
+    checkpoint.array(cluster_rx);
+    checkpoint.array(cluster_ry);
+    checkpoint.array(cluster_c);
+    checkpoint.array(cluster_s);
+    checkpoint.array(clusterStart);
+    checkpoint.array(clusterBlocks);
+    checkpoint.array(cluster_split);
+    checkpoint.array(cluster_strength);
+    checkpoint.array(cluster_mass);
+    checkpoint.array(cluster_iinertia);
+    checkpoint.array(cluster_px);
+    checkpoint.array(cluster_py);
+    checkpoint.array(cluster_cz);
+    checkpoint.array(cluster_sz);
+    checkpoint.array(cluster_vx);
+    checkpoint.array(cluster_vy);
+    checkpoint.array(cluster_wz);
+  } // checkpoint()
+
+  Scalar kineticEnergy(void) {
+    Scalar energy = 0.0;
+    for (int i = 0; i < Nblocks; i++) {
+      energy += mass[i]*(vx[i]*vx[i] + vy[i]*vy[i]) + (wz[i]*wz[i])/iinertia[i];
+    } // for i = ...
+    for (int b = 0; b < Nbodies; b++) {
+      energy += body_mass[b]*(body_vx[b]*body_vx[b] + body_vy[b]*body_vy[b]);
+    } // for b = ...
+    return 0.5*energy;
+  } // kineticEnergy()
+
+#ifndef CZM_HEADLESS
   void render(void) {
     
     // load material textures
@@ -351,8 +1104,8 @@ public:
     // draw blocks
     glBegin(GL_QUADS);
     for (int i = 0; i < Nblocks; i++) {
-      float s = sin(rz[i]);
-      float c = cos(rz[i]);
+      float s = sz[i];
+      float c = cz[i];
       float drx = (c-s)*halfh;
       float dry = (c+s)*halfh;
       float color[3] = { 1.0f, 1.0f, 1.0f };
@@ -366,52 +1119,124 @@ public:
       glColor4f(color[0], color[1], color[2], 1);
       glTexCoord2f(coords[0], coords[3]); glVertex2f(dhdL*px[i]-dry,dhdL*py[i]+drx);
     } // for i = ...
-    // draw player
-    if (player_mat != nullptr) {
+    // draw free bodies
+    for (int b = 0; b < Nbodies; b++) {
       float color[3] = { 1.0f, 1.0f, 1.0f };
-      float* coords = player_mat->coord;
+      float* coords = body_mat[b]->coord;
       glColor4f(color[0], color[1], color[2], 1);
-      glTexCoord2f(coords[0], coords[1]); glVertex2f(dhdL*player_px-halfh,dhdL*player_py-halfh);
+      glTexCoord2f(coords[0], coords[1]); glVertex2f(dhdL*body_px[b]-halfh,dhdL*body_py[b]-halfh);
       glColor4f(color[0], color[1], color[2], 1);
-      glTexCoord2f(coords[2], coords[1]); glVertex2f(dhdL*player_px+halfh,dhdL*player_py-halfh);
+      glTexCoord2f(coords[2], coords[1]); glVertex2f(dhdL*body_px[b]+halfh,dhdL*body_py[b]-halfh);
       glColor4f(color[0], color[1], color[2], 1);
-      glTexCoord2f(coords[2], coords[3]); glVertex2f(dhdL*player_px+halfh,dhdL*player_py+halfh);
+      glTexCoord2f(coords[2], coords[3]); glVertex2f(dhdL*body_px[b]+halfh,dhdL*body_py[b]+halfh);
       glColor4f(color[0], color[1], color[2], 1);
-      glTexCoord2f(coords[0], coords[3]); glVertex2f(dhdL*player_px-halfh,dhdL*player_py+halfh);
-    }
+      glTexCoord2f(coords[0], coords[3]); glVertex2f(dhdL*body_px[b]-halfh,dhdL*body_py[b]+halfh);
+    } // for b = ...
     glEnd();
 
     glDisable(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, 0);
   } // render()
+#endif // CZM_HEADLESS
 
   int Nblocks;
   float h; // block height in pixels (used for drawing)
-  float L; // characteristic block dimension (used for physical computations)
+  Scalar L; // characteristic block dimension (used for physical computations)
   float dhdL; // ratio of pixel dimension h to physical dimension L
   std::vector<Material*> mat;
-  std::vector<float> mass;
-  std::vector<float> imass;
-  std::vector<float> iinertia;
-  std::vector<float> px;
-  std::vector<float> py;
-  std::vector<float> rz;
-  std::vector<float> vx;
-  std::vector<float> vy;
-  std::vector<float> wz;
-  std::vector<float> fx;
-  std::vector<float> fy;
-  std::vector<float> mz;
-  std::vector<float> fixity;
+  std::vector<Scalar> mass;
+  std::vector<Scalar> imass;
+  std::vector<Scalar> iinertia;
+  std::vector<Coordinate> px;
+  std::vector<Coordinate> py;
+  std::vector<Scalar> cz; // cos of the block rotation
+  std::vector<Scalar> sz; // sin of the block rotation
+  std::vector<Scalar> vx;
+  std::vector<Scalar> vy;
+  std::vector<Scalar> wz;
+  std::vector<Scalar> fx;
+  std::vector<Scalar> fy;
+  std::vector<Scalar> mz;
+  std::vector<Scalar> fixity;
+  std::vector<int> boundary; // blocks with prescribed (ground motion) displacements
+  std::vector<int> level; // multi-rate level of each block (0: coarsest, stepped once per coarse step)
+  int finestLevel = 0;     // (0: single rate)
+
+  // sleeping of blocks at rest (islands connected by intact cohesive faces)
+  bool sleeping = false;          // enable sleeping
+  Scalar sleepVelocity = 1.0e-2;   // [m/s] (rotations are measured at the distance L)
+  Scalar sleepAcceleration = 5.0e-2; // [m/s^2] (about half of gravity)
+  int sleepSteps = 500;           // substeps at rest before an island may fall asleep
+  int sleepInterval = 50;         // substeps between searches for islands at rest
+  int sleepCounter = 0;
+  std::vector<char> asleep;
+  std::vector<int> quietSteps;    // substeps for which each block has remained at rest
+  std::vector<int> island;        // island of each free block (its smallest block index; -1: fixed)
+  std::vector<int> islandStart;   // CSR lists of the blocks of each island
+  std::vector<int> islandBlocks;
+  std::vector<int> frontier;      // awake blocks bonded to a sleeping block
+  std::vector<int> wakeRequests;  // sleeping blocks touched by a moving block or body
+  int Nsleeping = 0;
+
+  // rigid clusters of blocks joined by elastic faces
+  bool clustering = false;        // enable clustering
+  Scalar splitFraction = 0.5;      // fraction of the weakest face capacity at which a cluster is split
+  int clusterInterval = 50;       // substeps between searches for new clusters
+  int clusterCooldownPasses = 4;  // searches for which the blocks of a split cluster are not clustered again
+  int clusterCounter = 0;
+  int Nclusters = 0;
+  std::vector<int> cluster;       // cluster of each block (-1: none)
+  std::vector<int> clusterCooldown;
+  std::vector<Scalar> cluster_rx;  // offset and orientation of each clustered block in the frame of its cluster
+  std::vector<Scalar> cluster_ry;
+  std::vector<Scalar> cluster_c;
+  std::vector<Scalar> cluster_s;
+  std::vector<int> clusterStart;  // CSR lists of the blocks of each cluster
+  std::vector<int> clusterBlocks;
+  std::vector<char> cluster_split; // the cluster must be split
+  std::vector<Scalar> cluster_strength; // force capacity of the weakest face of each cluster
+  std::vector<Scalar> cluster_mass;
+  std::vector<Scalar> cluster_iinertia;
+  std::vector<Coordinate> cluster_px;  // center of mass
+  std::vector<Coordinate> cluster_py;
+  std::vector<Scalar> cluster_cz;
+  std::vector<Scalar> cluster_sz;
+  std::vector<Scalar> cluster_vx;
+  std::vector<Scalar> cluster_vy;
+  std::vector<Scalar> cluster_wz;
+  bool pendingSplit = false;
+
+  static const int SLICE_SIZE = 1024; // blocks per slice of the fused update
+  ThreadPool* pool = nullptr;
   
-  Material* player_mat;
-  float player_mass;
-  float player_px;
-  float player_py;
-  float player_vx;
-  float player_vy;
-  float player_fx;
-  float player_fy;
+
+  // free bodies (players, projectiles, debris)
+  int Nbodies;
+  std::vector<Material*> body_mat;
+  std::vector<Scalar> body_mass;
+  std::vector<Coordinate> body_px;
+  std::vector<Coordinate> body_py;
+  std::vector<Scalar> body_vx;
+  std::vector<Scalar> body_vy;
+  std::vector<Scalar> body_fx;
+  std::vector<Scalar> body_fy;
+
+  // contact broadphase over the block centers
+  SpatialHash broadphase;
+  bool broadphaseStale = true;
+  std::vector<int> candidates;
+
+  // block-to-block contact of fragments
+  Scalar contactStiffness = 1.0e+4;
+  Scalar contactViscosity = 1.0e+3;
+  Scalar skin = 0.25; // Verlet skin distance [m]
+  std::vector<int> bonds;          // 4 per block: grid neighbors still joined by a cohesive face (-1: none)
+  std::vector<char> fragment;      // the block has lost at least one cohesive face
+  int Nfragments;
+  std::vector<std::pair<int,int> > fragmentPairs; // Verlet list of candidate contact pairs
+  std::vector<Coordinate> verletX;      // block positions at the last Verlet list rebuild
+  std::vector<Coordinate> verletY;
+  bool verletStale = true;
 }; // Blocks
 
 #endif // BLOCKS_H
@@ -1,26 +1,34 @@
 #ifndef CZM_H
 #define CZM_H
 
+#ifndef CZM_HEADLESS
 #if __APPLE__
 #include <GLUT/glut.h>
 #else
 #include <GL/glut.h>
 #endif
+#endif // CZM_HEADLESS
 
 #include "Materials.h"
 #include "Grid.h"
 #include "Blocks.h"
 #include "GroundMotion.h"
 #include "CohesiveZoneManager.h"
+#include "Checkpoint.h"
+#include "Recorder.h"
 
 #include <iostream>
 #include <vector>
+#include <string>
+#include <algorithm>
+#include <cmath>
 
 class CZM {
 public:
 
   CZM() {
     simulate = false;
+    blocks.pool = &faces.pool;
   } // CZM()
 
   void initialize(int xcells, int ycells, float xsize, float ysize) {
@@ -41,51 +49,189 @@ public:
   void simulation() {
     simulate = true;
     time = 0.0;
+    estimatedDT = 0.0;
+    substepsToCheck = 0;
+    dispTimeHistory.seek(time);
 
     // initialize all blocks
     blocks.initialize(grid);
     
     // initialize all cohesive zones
     faces.initialize(grid);
+
+    // apply the external loads of the first substep
+    blocks.initializeForces(0.0, -gravity, drag_coefficient);
   } // initializeSimulation()
 
-  void timeIntegrate(float dt) {
+  // advance by one substep dt (of the finest multi-rate level, substep being its index within the coarse step)
+  void timeIntegrate(Coordinate dt, int substep = 0) {
     if (simulate) {
-      // initialize forces
-      blocks.zeroForces();
+      // (the block forces already hold the external loads of this substep)
 
-      // update acceleration time history
-      float ux_old;
-      float uy_old;
-      dispTimeHistory.evaluate(time, ux_old, uy_old);
+      // advance the ground motion over the substep
       time += dt;
-      float ux;
-      float uy;
-      dispTimeHistory.evaluate(time, ux, uy);
-      std::cout << ux << std::endl;
+      Coordinate dux;
+      Coordinate duy;
+      Scalar vx;
+      Scalar vy;
+      dispTimeHistory.advance(time, dt, dux, duy, vx, vy);
+      groundX = dispTimeHistory.currentX;
+      groundY = dispTimeHistory.currentY;
 
       // apply boundary conditions
-      blocks.applyIncrementalDisplacements(ux-ux_old, uy-uy_old, dt);
+      blocks.applyIncrementalDisplacements(dux, duy, vx, vy);
 
-      // apply body forces
-      float gravity = 9.8*1.0e-2; // [m/s^2]
-      blocks.applyBodyForce(0.0, -gravity);
+      // wake the sleeping islands disturbed since the last substep, and put the islands at rest to sleep
+      if (blocks.sleeping && blocks.updateSleeping()) faces.sortFaces(blocks);
 
-      // apply drag forces
-      float drag_coefficient = 0.0;
-      blocks.applyDragForce(drag_coefficient);
+      // split the rigid clusters overloaded during the last substep, and aggregate new ones
+      if (blocks.clustering) updateClusters();
 
       // apply cohesive forces
-      faces.applyCohesiveForces(blocks);
+      faces.applyCohesiveForces(blocks, substep);
 
       // apply contact forces
       blocks.applyContactForces();
 
-      // integrate block positions in time
-      blocks.timeIntegrate(dt);
+      // (the forces of this substep are complete: keep the base force, as the update below replaces them)
+      if (recorder.recording()) {
+	baseForceX = 0.0;
+	baseForceY = 0.0;
+	for (int i : blocks.boundary) {
+	  baseForceX += blocks.fx[i];
+	  baseForceY += blocks.fy[i] + gravity*blocks.mass[i];
+	} // for i = ...
+      }
+
+      // integrate block positions in time, and apply the body and drag forces of the next substep
+      if (integrator == Integrator::IMPLICIT) {
+	solverIterations += faces.solveImplicitStep(blocks, dt, dv);
+	blocks.timeIntegrate(dt, dv, 0.0, -gravity, drag_coefficient);
+      } else {
+	blocks.timeIntegrate(dt, 0.0, -gravity, drag_coefficient, substep);
+      }
+
+      // record the probes (the ground and the blocks are now all at the end of the substep)
+      recorder.sample(time);
     } // if (simulate)
   } // timeIntegrate()
 
+  // largest stable substep for the current state: the critical explicit time step (which grows as
+  // faces fail) reduced by the safety factor
+  Coordinate stableTimeStep(void) {
+    return safety*faces.criticalTimeStep(blocks);
+  } // stableTimeStep()
+
+  // largest stable multi-rate coarse step for the current state: the coarse step is limited by the block with
+  // the largest critical step, and by the smallest critical step refined by at most maxLevel levels (with
+  // maxLevel = 0, this is the stable time step)
+  Coordinate coarseTimeStep(void) {
+    Scalar dt = faces.criticalTimeStep(blocks);
+    return safety*std::min(faces.coarsestTimeStep(), dt*Scalar(1 << maxLevel));
+  } // coarseTimeStep()
+
+  // take one multi-rate coarse step of length coarseDT (using the critical steps estimated by the last
+  // coarseTimeStep or stableTimeStep): each block is stepped at the coarsest power-of-two fraction of coarseDT
+  // within its own stable step, and the faces at the finer level of their blocks; returns the number of substeps
+  int coarseStep(Coordinate coarseDT) {
+    if (!simulate) return 0;
+    int Nsubincrements = 1 << faces.assignLevels(blocks, coarseDT, safety, maxLevel);
+    Coordinate dt = coarseDT / Nsubincrements;
+    for (int i = 0; i < Nsubincrements; i++) timeIntegrate(dt, i);
+    return Nsubincrements;
+  } // coarseStep()
+
+  // advance the simulation by a frame of length frameDT, in the smallest number of equal (coarse) steps
+  // that do not exceed the stable (coarse) time step; returns the number of substeps taken
+  int advance(Coordinate frameDT) {
+    if (!simulate) return 0;
+    if (integrator == Integrator::IMPLICIT) {
+      int Nsubincrements = std::max(1, int(ceil(frameDT/(implicitScale*stableTimeStep()))));
+      for (int i = 0; i < Nsubincrements; i++) timeIntegrate(frameDT / Nsubincrements);
+      return Nsubincrements;
+    }
+    int Nincrements = std::max(1, int(ceil(frameDT/coarseTimeStep())));
+    int Nsubincrements = 0;
+    for (int i = 0; i < Nincrements; i++) Nsubincrements += coarseStep(frameDT / Nincrements);
+    return Nsubincrements;
+  } // advance()
+
+  // number of threads used to assemble the cohesive forces (n < 1: one per hardware thread)
+  void setThreads(int n) {
+    faces.setThreads(n);
+  } // setThreads()
+
+  // save the simulation state to a checkpoint file between substeps: the state is copied at once, and
+  // written in the background while the simulation continues (see Checkpoint)
+  void saveCheckpoint(const std::string& filename) {
+    checkpointer.beginSave();
+    checkpoint(checkpointer);
+    checkpointer.write(filename);
+  } // saveCheckpoint()
+
+  // restore the simulation state from a checkpoint file, into a simulation started (by simulation()) from the
+  // same layout; a driver that resumes from estimatedDT and substepsToCheck continues exactly as the saved run
+  // would have. Returns false if the checkpoint does not fit the layout (the simulation must then be restarted)
+  bool loadCheckpoint(const char* filename) {
+    if (!checkpointer.open(filename)) return false;
+    checkpoint(checkpointer);
+    bool restored = checkpointer.ok;
+    checkpointer.close();
+    if (!restored) std::cerr << "ERROR: Checkpoint " << filename << " does not match the current layout" << std::endl;
+    return restored;
+  } // loadCheckpoint()
+
+  // save the simulation state into a completed in-memory image, and restore it (into a simulation started from
+  // the same layout, as for loadCheckpoint): a prepared state may thus be shared by many runs at once
+  void saveState(Checkpoint& image) {
+    image.beginSave();
+    checkpoint(image);
+    image.endSave();
+  } // saveState()
+
+  bool loadState(const Checkpoint& image) {
+    if (!checkpointer.open(image)) return false;
+    checkpoint(checkpointer);
+    bool restored = checkpointer.ok;
+    checkpointer.close();
+    if (!restored) std::cerr << "ERROR: The saved state does not match the current layout" << std::endl;
+    return restored;
+  } // loadState()
+
+  // register the standard probes with the recorder: the ground displacement, the force of the blocks on the
+  // ground (the sum of the forces on the boundary blocks over the substep, less their weight), the number of
+  // failed faces and the number of blocks that have lost a face. Every probe is sampled at the end of the
+  // substep. (With multi-rate levels, a face adds its force weighted by the substeps of its level at the
+  // substeps it is stepped, so that the base force is only meaningful as a mean over a coarse step)
+  void addStandardProbes(void) {
+    recorder.addProbe("ground_x", [this]() { return double(groundX); });
+    recorder.addProbe("ground_y", [this]() { return double(groundY); });
+    recorder.addProbe("base_force_x", [this]() { return baseForceX; });
+    recorder.addProbe("base_force_y", [this]() { return baseForceY; });
+    recorder.addProbe("failed_faces", [this]() { return double(faces.totalFaces() - faces.activeFaces()); });
+    recorder.addProbe("fragment_blocks", [this]() { return double(blocks.Nfragments); });
+  } // addStandardProbes()
+
+  // register probes of the position and velocity of block i
+  void addBlockProbes(int i) {
+    std::string block = "block" + std::to_string(i);
+    recorder.addProbe(block + "_x",  [this,i]() { return double(blocks.px[i]); });
+    recorder.addProbe(block + "_y",  [this,i]() { return double(blocks.py[i]); });
+    recorder.addProbe(block + "_vx", [this,i]() { return double(blocks.vx[i]); });
+    recorder.addProbe(block + "_vy", [this,i]() { return double(blocks.vy[i]); });
+  } // addBlockProbes()
+
+  void checkpoint(Checkpoint& checkpoint) {
+    checkpoint.value(time);
+    checkpoint.value(solverIterations);
+    checkpoint.value(estimatedDT);
+    checkpoint.value(substepsToCheck);
+    dispTimeHistory.checkpoint(checkpoint);
+    blocks.checkpoint(checkpoint);
+    faces.checkpoint(checkpoint);
+  } // checkpoint()
+
+#ifndef CZM_HEADLESS
   void render() {
     if (simulate) {
       // render dynamic blocks
@@ -95,6 +241,7 @@ public:
       grid.render();
     }
   } // renderGrid()
+#endif // CZM_HEADLESS
   
   MaterialInventory inventory;
   Grid grid;
@@ -102,9 +249,54 @@ public:
   CohesiveZoneManager faces;
 
   bool simulate = false;
-  float time;
+  Coordinate time; // (accumulated over every substep)
+  float gravity = 9.8*1.0e-2; // [m/s^2]
+  float drag_coefficient = 0.0;
+  float safety = 0.8; // fraction of the critical time step used by advance()
+  int maxLevel = 0;   // finest multi-rate level used by advance() (0: a single rate for all blocks)
+
+  // EXPLICIT integrates the forces of each substep directly (stable up to the critical time step), whereas
+  // IMPLICIT solves a linearized backward Euler step over the tangent of all faces, allowing substeps of
+  // implicitScale times the stable time step in advance() (its accuracy then limits the step)
+  enum class Integrator { EXPLICIT, IMPLICIT };
+  Integrator integrator = Integrator::EXPLICIT;
+  float implicitScale = 20.0;
+  long solverIterations = 0; // conjugate gradient iterations of all implicit substeps
+
+  // state of the driving loop (see czm_batch), saved with the checkpoint: the step last estimated by
+  // coarseTimeStep() or stableTimeStep() (0: none yet), and the substeps left until the next check, at which the
+  // step is re-estimated. A run saved between checks thus keeps its estimate until the same substep on restart
+  Coordinate estimatedDT = 0.0;
+  long substepsToCheck = 0;
 
   GroundMotion dispTimeHistory;
+  Coordinate groundX = 0.0; // current ground displacement
+  Coordinate groundY = 0.0;
+  Recorder recorder;        // time histories of the registered probes
+  double baseForceX = 0.0;  // force of the blocks on the ground over the last substep (only kept while recording)
+  double baseForceY = 0.0;
+
+private:
+
+  // rigid clusters are only used by single-rate explicit stepping (any clusters are dissolved otherwise); new
+  // clusters are formed from the elastic faces every clusterInterval substeps
+  void updateClusters(void) {
+    bool changed = blocks.splitClusters();
+    if ((integrator == Integrator::IMPLICIT) || (blocks.finestLevel > 0)) {
+      changed = changed || (blocks.Nclusters > 0);
+      blocks.clearClusters();
+    } else if (++blocks.clusterCounter >= blocks.clusterInterval) {
+      blocks.clusterCounter = 0;
+      faces.elasticFaces(blocks, clusterPairs, clusterCapacities);
+      changed = blocks.formClusters(clusterPairs, clusterCapacities) || changed;
+    }
+    if (changed) faces.sortFaces(blocks);
+  } // updateClusters()
+
+  std::vector<Scalar> dv; // velocity increments of the implicit integrator
+  Checkpoint checkpointer;  // (holds the image being written in the background)
+  std::vector<std::pair<int,int> > clusterPairs; // elastic faces (as pairs of blocks), and the force capacity of each
+  std::vector<Scalar> clusterCapacities;
 }; // CZM
 
 #endif // CZM_H
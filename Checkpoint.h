@@ -0,0 +1,262 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "Precision.h"
+#include <vector>
+#include <string>
+#include <thread>
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define CZM_MMAP 1
+#endif
+
+// Versioned binary checkpoint of the simulation state: a header, followed by a sequence of records (one per
+// array or value, in the order in which the state is visited), each holding its element count and size and
+// padded so that its data starts at a multiple of ALIGNMENT bytes. On restart the file is memory-mapped, and
+// every array is copied straight out of the mapping into its SoA vector.
+//
+// The same visitor saves and loads the state: each class lists its state in checkpoint(Checkpoint&), calling
+// value(), array() and match() (for the sizes that must agree with the layout the state is restored into).
+// Saving only copies the state into an in-memory image; write() then hands the image to a background thread,
+// which writes it to a temporary file and renames it over the target, so that the stepping loop only stalls
+// for the copy, and a job preempted mid-write still leaves the previous checkpoint intact.
+class Checkpoint {
+public:
+
+  static const uint32_t VERSION = 5;
+  static const int ALIGNMENT = 64;
+
+  struct Header {
+    char magic[8];           // "CZMCHKPT"
+    uint32_t version;
+    uint32_t scalarSize;     // sizeof(Scalar) and sizeof(Coordinate) of the writer (see Precision.h)
+    uint32_t coordinateSize;
+    uint32_t records;
+    uint64_t size;           // bytes, including the header
+  }; // Header
+
+  Checkpoint() = default;
+  Checkpoint(const Checkpoint&) = delete;
+  Checkpoint& operator=(const Checkpoint&) = delete;
+
+  ~Checkpoint() {
+    wait();
+    close();
+  } // ~Checkpoint()
+
+  bool saving(void) const {
+    return (mode == Mode::SAVE);
+  } // saving()
+
+  // start a new image (waiting for the previous one to be written first)
+  void beginSave(void) {
+    wait();
+    close();
+    mode = Mode::SAVE;
+    ok = true;
+    image.assign(ALIGNMENT, 0);
+    records = 0;
+  } // beginSave()
+
+  // complete the saved image (which may then be restored from memory, by open(const Checkpoint&))
+  void endSave(void) {
+    Header* header = (Header*)image.data();
+    memcpy(header->magic, "CZMCHKPT", 8);
+    header->version = VERSION;
+    header->scalarSize = sizeof(Scalar);
+    header->coordinateSize = sizeof(Coordinate);
+    header->records = records;
+    header->size = image.size();
+    mode = Mode::NONE;
+  } // endSave()
+
+  // write the saved image to a file, in the background
+  void write(const std::string& filename) {
+    endSave();
+    writer = std::thread([this,filename]() {
+      std::string temporary = filename + ".tmp";
+      FILE* file = fopen(temporary.c_str(), "wb");
+      bool written = (file != nullptr) && (fwrite(image.data(), 1, image.size(), file) == image.size());
+      if (file != nullptr) written = (fclose(file) == 0) && written;
+      if (written) written = (rename(temporary.c_str(), filename.c_str()) == 0);
+      if (!written) std::cerr << "ERROR: Unable to write checkpoint " << filename << std::endl;
+    });
+  } // write()
+
+  // wait for the background write (if any) to complete
+  void wait(void) {
+    if (writer.joinable()) writer.join();
+  } // wait()
+
+  // map a checkpoint file for loading, and check its header; returns false if it cannot be restored
+  bool open(const char* filename) {
+    wait();
+    close();
+#ifdef CZM_MMAP
+    int descriptor = ::open(filename, O_RDONLY);
+    struct stat status;
+    if ((descriptor >= 0) && (fstat(descriptor, &status) == 0) && (status.st_size >= ALIGNMENT)) {
+      void* mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+      if (mapping != MAP_FAILED) {
+	data = (const char*)mapping;
+	size = status.st_size;
+	mapped = true;
+      }
+    }
+    if (descriptor >= 0) ::close(descriptor);
+#else
+    FILE* file = fopen(filename, "rb");
+    if (file != nullptr) {
+      fseek(file, 0, SEEK_END);
+      image.resize(ftell(file));
+      fseek(file, 0, SEEK_SET);
+      if (fread(image.data(), 1, image.size(), file) == image.size()) {
+	data = image.data();
+	size = image.size();
+      }
+      fclose(file);
+    }
+#endif
+    if (data == nullptr) {
+      std::cerr << "ERROR: Unable to read checkpoint " << filename << std::endl;
+      return false;
+    }
+    return start(filename);
+  } // open()
+
+  // restore from the completed in-memory image of another checkpoint; the image is only read, so that
+  // several checkpoints (e.g. on different threads) may restore the same image at once
+  bool open(const Checkpoint& saved) {
+    wait();
+    close();
+    data = saved.image.data();
+    size = saved.image.size();
+    return start("the saved state");
+  } // open()
+
+  // release the mapping of a loaded checkpoint
+  void close(void) {
+#ifdef CZM_MMAP
+    if (mapped) munmap((void*)data, size);
+#endif
+    if (mode == Mode::LOAD) image.clear();
+    mapped = false;
+    data = nullptr;
+    size = 0;
+    if (mode == Mode::LOAD) mode = Mode::NONE;
+  } // close()
+
+  // save or restore a single value
+  template <class T>
+  void value(T& x) {
+    static_assert(plain<T>(), "checkpointed values must be plain data");
+    if (mode == Mode::SAVE) {
+      record(&x, 1, sizeof(T));
+    } else if (const char* source = next(1, sizeof(T))) {
+      memcpy((void*)&x, source, sizeof(T));
+    }
+  } // value()
+
+  // save or restore an array (resized to the saved length on restore)
+  template <class T>
+  void array(std::vector<T>& x) {
+    static_assert(plain<T>(), "checkpointed arrays must hold plain data");
+    if (mode == Mode::SAVE) {
+      record(x.data(), x.size(), sizeof(T));
+    } else if (const char* source = next(-1, sizeof(T))) {
+      x.resize(count);
+      if (count > 0) memcpy((void*)x.data(), source, count*sizeof(T));
+    }
+  } // array()
+
+  // save a size of the layout, or check that it agrees with the saved one on restore
+  void match(int x) {
+    int saved = x;
+    value(saved);
+    if (saved != x) ok = false;
+  } // match()
+
+  bool ok = false; // false once a restore has met a record that does not fit the state being restored
+
+private:
+
+  // check the header of the loaded data, and start restoring from its first record
+  bool start(const char* filename) {
+    const Header* header = (const Header*)data;
+    if ((size < sizeof(Header)) || (memcmp(header->magic, "CZMCHKPT", 8) != 0) || (header->version != VERSION) || (header->size != size)) {
+      std::cerr << "ERROR: " << filename << " is not a complete checkpoint of version " << VERSION << std::endl;
+      close();
+      return false;
+    }
+    if ((header->scalarSize != sizeof(Scalar)) || (header->coordinateSize != sizeof(Coordinate))) {
+      std::cerr << "ERROR: " << filename << " was written by a build of a different precision" << std::endl;
+      close();
+      return false;
+    }
+    mode = Mode::LOAD;
+    ok = true;
+    offset = ALIGNMENT;
+    return true;
+  } // start()
+
+  // append a record to the image
+  void record(const void* source, uint64_t elements, uint32_t elementSize) {
+    uint64_t prefix[2] = { elements, elementSize };
+    size_t start = image.size();
+    size_t bytes = elements*elementSize;
+    image.resize(start + ALIGNMENT + padded(bytes), 0);
+    memcpy(&image[start], prefix, sizeof(prefix));
+    if (bytes > 0) memcpy(&image[start+ALIGNMENT], source, bytes);
+    records++;
+  } // record()
+
+  // locate the data of the next record (of the given element count, or any count if elements < 0)
+  const char* next(int64_t elements, uint32_t elementSize) {
+    if (!ok || (offset + ALIGNMENT > size)) {
+      ok = false;
+      return nullptr;
+    }
+    uint64_t prefix[2];
+    memcpy(prefix, data+offset, sizeof(prefix));
+    count = prefix[0];
+    size_t bytes = count*prefix[1];
+    if ((prefix[1] != elementSize) || ((elements >= 0) && (count != uint64_t(elements))) || (offset + ALIGNMENT + bytes > size)) {
+      ok = false;
+      return nullptr;
+    }
+    const char* source = data + offset + ALIGNMENT;
+    offset += ALIGNMENT + padded(bytes);
+    return source;
+  } // next()
+
+  // (std::pair of plain types is not trivially copyable, but is safe to copy bytewise)
+  template <class T>
+  static constexpr bool plain(void) {
+    return std::is_standard_layout<T>::value && std::is_trivially_destructible<T>::value;
+  } // plain()
+
+  static size_t padded(size_t bytes) {
+    return (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+  } // padded()
+
+  enum class Mode { NONE, SAVE, LOAD };
+  Mode mode = Mode::NONE;
+  std::vector<char> image; // saved state (or, without mmap, the loaded file)
+  uint32_t records = 0;
+  std::thread writer;
+  const char* data = nullptr; // loaded checkpoint
+  size_t size = 0;
+  size_t offset = 0;
+  uint64_t count = 0;
+  bool mapped = false;
+}; // Checkpoint
+
+#endif // CHECKPOINT_H
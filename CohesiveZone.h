@@ -3,55 +3,418 @@
 
 #include "Materials.h"
 #include "Blocks.h"
+#include "Simd.h"
+#include "SparseMatrix.h"
 #include <vector>
+#include <atomic>
+#include <algorithm>
 #include <cmath>
 
 enum Orientation { X, Y };
 
+// per-face forces and moments, stored by the face pass for gather-based assembly
+struct FaceForces {
+  Scalar* fx;      // force applied to the minus block (the plus block receives -fx)
+  Scalar* fy;      // force applied to the minus block (the plus block receives -fy)
+  Scalar* mzMinus; // moment applied to the minus block
+  Scalar* mzPlus;  // moment applied to the plus block (with opposite sign)
+}; // FaceForces
+
 class CohesiveZone {
 public:
 
+  CohesiveZone() {
+    workspace.resize(1);
+  } // CohesiveZone()
+
   virtual ~CohesiveZone() = default;
   
-  void insertFaceX(int left, int right) {
+  // faces are colored by the parity of their grid column (x-faces) or row (y-faces):
+  // no two faces of the same orientation and color share a block
+  void insertFaceX(int left, int right, int color = 0) {
+    xColor[color%2].push_back(xFaceIDs.size());
     xFaceIDs.push_back(std::pair<int,int>(left,right));
   } // insertFaceX()
 
-  void insertFaceY(int lower, int upper) {
+  void insertFaceY(int lower, int upper, int color = 0) {
+    yColor[color%2].push_back(yFaceIDs.size());
     yFaceIDs.push_back(std::pair<int,int>(lower,upper));
   } // insertFaceY()
 
   virtual void initialize(void) = 0;
 
-  virtual void computeTraction(float* ux, float* uy, float* vx, float* vy, float* nx, float* ny, float* tx, float* ty, float divdx, Orientation dir, int size) = 0;
+  // compute the tractions at size quadrature points, whose history variables are located at indices ids
+  virtual void computeTraction(Scalar* ux, Scalar* uy, Scalar* vx, Scalar* vy, Scalar* nx, Scalar* ny, Scalar* tx, Scalar* ty, Scalar divdx, Orientation dir, int size, const int* ids) = 0;
+
+  // apply the cohesive forces of a list of faces, using the fused kernel of the law (overridden by each law)
+  virtual void applyFusedForces(Blocks& blocks, Orientation dir, const int* faces, int count) {
+    applyChunkedForces(blocks, dir, faces, count, workspace[0]);
+  } // applyFusedForces()
+
+  // true if computeTraction dispatches to explicit SIMD kernels on the current CPU
+  virtual bool vectorized(void) { return false; }
+
+  // true if both quadrature points of a face have failed for good (the face will never carry traction again)
+  virtual bool faceFailed(Orientation dir, int face) { return false; }
+
+  // current stiffness and viscosity of a face, summed over its quadrature points (each quadrature point acts
+  // as a spring and dashpot between the blocks; upper bounds are used to estimate the stable time step)
+  virtual void faceStiffness(Orientation dir, int face, Scalar& faceStiffness, Scalar& faceViscosity) {
+    faceStiffness = 0.0;
+    faceViscosity = 0.0;
+  } // faceStiffness()
+
+  // save or restore the state of the faces: the active face lists (compacted and sorted as the faces fail, fall
+  // asleep or join clusters), extended by each law with its history variables
+  virtual void checkpoint(Checkpoint& checkpoint) {
+    checkpoint.match(xFaceIDs.size());
+    checkpoint.match(yFaceIDs.size());
+    for (int color = 0; color < 2; color++) {
+      checkpoint.array(xColor[color]);
+      checkpoint.array(yColor[color]);
+      checkpoint.array(xLevelCount[color]);
+      checkpoint.array(yLevelCount[color]);
+    } // for color = ...
+  } // checkpoint()
+
+  // traction at which a face that is still elastic (undamaged and without slip at both quadrature points) leaves
+  // the elastic regime, or zero if it already has; used to aggregate blocks joined by elastic faces into rigid clusters
+  virtual Scalar elasticStrength(Orientation dir, int face) { return 0.0; }
+
+  // linearized response of quadrature point qp (history index 2*face+j) to its relative displacement and velocity,
+  // in the face coordinate system: the forces change by kn, kt per unit normal and tangential relative displacement,
+  // and by cn, ct per unit relative velocity (un and ut are the current relative displacements, normalized by the
+  // face length divdx^-1, as in the traction kernels). Used to assemble the tangent of the implicit integrator
+  virtual void quadratureTangent(Orientation dir, int qp, Scalar un, Scalar ut, Scalar divdx, Scalar& kn, Scalar& kt, Scalar& cn, Scalar& ct) {
+    kn = 0.0;
+    kt = 0.0;
+    cn = 0.0;
+    ct = 0.0;
+  } // quadratureTangent()
+
+  // drop the fully failed faces from the active face lists, keeping the order of the remaining faces, and
+  // append the (minus,plus) blocks of each dropped face to failedFaces; the laws set pendingFailure
+  // whenever a quadrature point fails, so that this only runs when needed
+  void compactFaces(std::vector<std::pair<int,int> >& failedFaces) {
+    pendingFailure.store(false, std::memory_order_relaxed);
+    for (int color = 0; color < 2; color++) {
+      compactFaces(Orientation::X, xColor[color], failedFaces);
+      compactFaces(Orientation::Y, yColor[color], failedFaces);
+    } // for color = ...
+  } // compactFaces()
+
+  void compactFaces(Orientation dir, std::vector<int>& faces, std::vector<std::pair<int,int> >& failedFaces) {
+    const std::vector<std::pair<int,int> >& faceIDs = (dir == Orientation::X) ? xFaceIDs : yFaceIDs;
+    int active = 0;
+    for (int face : faces) {
+      if (!faceFailed(dir, face)) {
+	faces[active++] = face;
+	continue;
+      }
+      failedFaces.push_back(faceIDs[face]);
+      if (forces[dir].fx != nullptr) {
+	// the face no longer contributes to the gather-based assembly
+	forces[dir].fx[face] = 0.0;
+	forces[dir].fy[face] = 0.0;
+	forces[dir].mzMinus[face] = 0.0;
+	forces[dir].mzPlus[face] = 0.0;
+      }
+    } // for face = ...
+    faces.resize(active);
+  } // compactFaces()
+
+  // number of faces still passed to the face kernels
+  int activeFaces(void) {
+    return xColor[0].size() + xColor[1].size() + yColor[0].size() + yColor[1].size();
+  } // activeFaces()
+
+  // multi-rate stepping, sleeping and clusters: a face is stepped at the finer of the levels of its two blocks, unless
+  // all of its free blocks are asleep or both of its blocks belong to the same rigid cluster. The active faces of each
+  // color are (stably) sorted by decreasing level, with the skipped faces last, so that the faces stepped at any substep
+  // form a prefix of each list; the faces of level l or finer are counted for every level (no counts: all faces are
+  // stepped at every substep)
+  void sortFaces(const Blocks& blocks) {
+    for (int color = 0; color < 2; color++) {
+      sortFaces(blocks, xFaceIDs, xColor[color], xLevelCount[color]);
+      sortFaces(blocks, yFaceIDs, yColor[color], yLevelCount[color]);
+    } // for color = ...
+  } // sortFaces()
+
+  void sortFaces(const Blocks& blocks, const std::vector<std::pair<int,int> >& faceIDs, std::vector<int>& faces, std::vector<int>& levelCount) {
+    levelCount.clear();
+    if ((blocks.finestLevel == 0) && (!blocks.sleeping || (blocks.Nsleeping == 0)) && (blocks.Nclusters == 0)) return;
+    auto level = [&](int face) {
+      int minus = faceIDs[face].first;
+      int plus  = faceIDs[face].second;
+      if ((blocks.Nclusters > 0) && (blocks.cluster[minus] >= 0) && (blocks.cluster[minus] == blocks.cluster[plus])) return -1;
+      if (blocks.sleeping && (blocks.asleep[minus] || blocks.asleep[plus]) &&
+	  (blocks.asleep[minus] || (blocks.fixity[minus] == 0.0)) && (blocks.asleep[plus] || (blocks.fixity[plus] == 0.0))) return -1;
+      return std::max(blocks.level[minus], blocks.level[plus]);
+    };
+    std::stable_sort(faces.begin(), faces.end(), [&](int a, int b) { return level(a) > level(b); });
+    levelCount.assign(blocks.finestLevel+1, 0);
+    for (int face : faces) {
+      if (level(face) >= 0) levelCount[level(face)]++;
+    } // for face = ...
+    for (int l = blocks.finestLevel-1; l >= 0; l--) levelCount[l] += levelCount[l+1];
+  } // sortFaces()
+
+  // number of leading faces of a color list stepped at a substep whose coarsest stepped level is minLevel
+  int activeCount(Orientation dir, int color, int minLevel) {
+    const std::vector<int>& levelCount = (dir == Orientation::X) ? xLevelCount[color] : yLevelCount[color];
+    if (levelCount.empty()) return (dir == Orientation::X) ? xColor[color].size() : yColor[color].size();
+    return levelCount[minLevel];
+  } // activeCount()
+
+  // apply the cohesive forces of a list of faces, using either the fused or the chunked face pass
+  void applyForces(Blocks& blocks, Orientation dir, const int* faces, int count, int thread = 0) {
+    if (chunked) {
+      applyChunkedForces(blocks, dir, faces, count, workspace[thread]);
+    } else {
+      applyFusedForces(blocks, dir, faces, count);
+    }
+  } // applyForces()
 
+  // apply the cohesive forces of all faces to the blocks
   void applyForces(Blocks& blocks) {
-    // declare local workspace arrays
-    int MAX_SIZE = 256;
-    float nx[MAX_SIZE];
-    float ny[MAX_SIZE];
-    float ux[MAX_SIZE];
-    float uy[MAX_SIZE];
-    float vx[MAX_SIZE];
-    float vy[MAX_SIZE];
-    float tx[MAX_SIZE];
-    float ty[MAX_SIZE];
-    float rxm[MAX_SIZE];
-    float rym[MAX_SIZE];
-    float rxp[MAX_SIZE];
-    float ryp[MAX_SIZE];
+    for (int color = 0; color < 2; color++) {
+      applyForces(blocks, Orientation::X, xColor[color].data(), xColor[color].size());
+    } // for color = ...
+    for (int color = 0; color < 2; color++) {
+      applyForces(blocks, Orientation::Y, yColor[color].data(), yColor[color].size());
+    } // for color = ...
+  } // applyForces()
+
+  // pointers to the kinematic quantities of a set of quadrature points
+  struct Quadrature {
+    Scalar* nx;
+    Scalar* ny;
+    Scalar* ux;
+    Scalar* uy;
+    Scalar* vx;
+    Scalar* vy;
+    Scalar* rxm;
+    Scalar* rym;
+    Scalar* rxp;
+    Scalar* ryp;
+  }; // Quadrature
+
+  // number of faces per chunk of the face pass: the workspace arrays then occupy 13 KB,
+  // which remains resident in L1 cache regardless of the total number of faces
+  static const int CHUNK_SIZE = 128;
+
+  // persistent workspace holding the quadrature point data of one chunk of faces
+  struct Workspace {
+    Scalar nx[2*CHUNK_SIZE];
+    Scalar ny[2*CHUNK_SIZE];
+    Scalar ux[2*CHUNK_SIZE];
+    Scalar uy[2*CHUNK_SIZE];
+    Scalar vx[2*CHUNK_SIZE];
+    Scalar vy[2*CHUNK_SIZE];
+    Scalar tx[2*CHUNK_SIZE];
+    Scalar ty[2*CHUNK_SIZE];
+    Scalar rxm[2*CHUNK_SIZE];
+    Scalar rym[2*CHUNK_SIZE];
+    Scalar rxp[2*CHUNK_SIZE];
+    Scalar ryp[2*CHUNK_SIZE];
+    int   ids[2*CHUNK_SIZE];
+  }; // Workspace
+
+  // allocate one workspace per thread that may call applyForces concurrently
+  void setThreads(int nthreads) {
+    workspace.resize(std::max(nthreads,1));
+  } // setThreads()
+
+  void applyChunkedForces(Blocks& blocks, Orientation dir, const int* faces, int count, Workspace& work) {
+    // stream through the faces in fixed-size chunks, so that the workspace stays cache-resident
+    for (int begin = 0; begin < count; begin += CHUNK_SIZE) {
+      if (dir == Orientation::X) {
+	applyChunkedForces<Orientation::X>(blocks, faces+begin, std::min(CHUNK_SIZE, count-begin), work);
+      } else {
+	applyChunkedForces<Orientation::Y>(blocks, faces+begin, std::min(CHUNK_SIZE, count-begin), work);
+      }
+    } // for begin = ...
+  } // applyChunkedForces()
+
+  template <Orientation dir>
+  void applyChunkedForces(Blocks& blocks, const int* faces, int size, Workspace& work) {
+    // alias the persistent workspace arrays
+    Quadrature q = { work.nx, work.ny, work.ux, work.uy, work.vx, work.vy, work.rxm, work.rym, work.rxp, work.ryp };
+    const std::pair<int,int>* faceIDs = (dir == Orientation::X) ? xFaceIDs.data() : yFaceIDs.data();
+
+    // define local constants
+    Scalar dx = blocks.L;
+    Scalar divdx = 1.0/dx;
+    Scalar halfdx = 0.5*dx;
+    Scalar divsqrt3 = 1.0/sqrt(3.0);
+
+    // compute the kinematics of all faces in the current chunk
+    for (int i = 0; i < size; i++) {
+      int face = faces[i];
+      computeKinematics<dir>(blocks, faceIDs[face].first, faceIDs[face].second, halfdx, divsqrt3, q, 2*i);
+      work.ids[2*i]   = 2*face;
+      work.ids[2*i+1] = 2*face+1;
+    } // for i = ...
+
+    // compute the cohesive traction vectors at each quadrature point
+    computeTraction(q.ux,q.uy,q.vx,q.vy,q.nx,q.ny,work.tx,work.ty,divdx,dir,2*size,work.ids);
+
+    // sum the cohesive tractions of all faces in the current chunk to the applied block forces
+    if (gather) {
+      for (int i = 0; i < size; i++) {
+	int face = faces[i];
+	storeForces(forces[dir], face, q, work.tx, work.ty, 2*i, dx, halfdx, levelWeight(blocks, faceIDs[face].first, faceIDs[face].second));
+      } // for i = ...
+    } else {
+      for (int i = 0; i < size; i++) {
+	int face = faces[i];
+	scatterForces(blocks, faceIDs[face].first, faceIDs[face].second, q, work.tx, work.ty, 2*i, dx, halfdx, levelWeight(blocks, faceIDs[face].first, faceIDs[face].second));
+      } // for i = ...
+    }
+  } // applyChunkedForces()
+
+  // fused kernel: kinematics, traction and force scatter are evaluated in a single pass per face,
+  // with the constitutive law resolved at compile time (Law::Kernel is inlined into the loop)
+  template <class Law, Orientation dir>
+  void fusedForces(Blocks& blocks, const int* faces, int count) {
+    const std::pair<int,int>* faceIDs = (dir == Orientation::X) ? xFaceIDs.data() : yFaceIDs.data();
 
     // define local constants
-    float dx = blocks.L;
-    float divdx = 1.0/dx;
-    float halfdx = 0.5*dx;
-    float divsqrt3 = 1.0/sqrt(3.0);
+    Scalar dx = blocks.L;
+    Scalar divdx = 1.0/dx;
+    Scalar halfdx = 0.5*dx;
+    Scalar divsqrt3 = 1.0/sqrt(3.0);
+    typename Law::Kernel traction(*static_cast<Law*>(this), dir, divdx);
 
-    // loop over all x-faces
-    for (int i = 0; i < xFaceIDs.size(); i++) {
-      // get the global block ids of the current x-face
-      int left  = xFaceIDs[i].first;
-      int right = xFaceIDs[i].second;
+    // register-resident quadrature point data of the current face
+    Scalar nx[2], ny[2], ux[2], uy[2], vx[2], vy[2], tx[2], ty[2], rxm[2], rym[2], rxp[2], ryp[2];
+    Quadrature q = { nx, ny, ux, uy, vx, vy, rxm, rym, rxp, ryp };
+
+    // loop over all listed faces
+    for (int k = 0; k < count; k++) {
+      int i = faces[k];
+      int minus = faceIDs[i].first;
+      int plus  = faceIDs[i].second;
+      computeKinematics<dir>(blocks, minus, plus, halfdx, divsqrt3, q, 0);
+      traction(2*i,   ux[0], uy[0], vx[0], vy[0], nx[0], ny[0], tx[0], ty[0]);
+      traction(2*i+1, ux[1], uy[1], vx[1], vy[1], nx[1], ny[1], tx[1], ty[1]);
+      if (gather) {
+	storeForces(forces[dir], i, q, tx, ty, 0, dx, halfdx, levelWeight(blocks, minus, plus));
+      } else {
+	scatterForces(blocks, minus, plus, q, tx, ty, 0, dx, halfdx, levelWeight(blocks, minus, plus));
+      }
+    } // for k = ...
+  } // fusedForces()
+
+  template <class Law>
+  void fusedForces(Blocks& blocks, Orientation dir, const int* faces, int count) {
+    if (dir == Orientation::X) {
+      fusedForces<Law,Orientation::X>(blocks, faces, count);
+    } else {
+      fusedForces<Law,Orientation::Y>(blocks, faces, count);
+    }
+  } // fusedForces()
+
+  // add the linearized response of a list of faces to the implicit system (see CohesiveZoneManager::solveImplicitStep):
+  // each quadrature point adds B^T G B to the matrix A, with G = (dt C + dt^2 K) its tangent in the global frame and
+  // B mapping the velocities (x, y, rotation) of its two blocks to its relative velocity, and -dt^2 B^T K B v to
+  // the right hand side b. Fixed blocks are left out (their rows and columns are not coupled)
+  void assembleTangent(Blocks& blocks, Orientation dir, const int* faces, int count, Scalar dt, BlockSparseMatrix& A, std::vector<Scalar>& b) {
+    if (dir == Orientation::X) {
+      assembleTangent<Orientation::X>(blocks, faces, count, dt, A, b);
+    } else {
+      assembleTangent<Orientation::Y>(blocks, faces, count, dt, A, b);
+    }
+  } // assembleTangent()
+
+  template <Orientation dir>
+  void assembleTangent(Blocks& blocks, const int* faces, int count, Scalar dt, BlockSparseMatrix& A, std::vector<Scalar>& b) {
+    const std::pair<int,int>* faceIDs = (dir == Orientation::X) ? xFaceIDs.data() : yFaceIDs.data();
+
+    // define local constants
+    Scalar dx = blocks.L;
+    Scalar divdx = 1.0/dx;
+    Scalar halfdx = 0.5*dx;
+    Scalar divsqrt3 = 1.0/sqrt(3.0);
+
+    // register-resident quadrature point data of the current face
+    Scalar nx[2], ny[2], ux[2], uy[2], vx[2], vy[2], rxm[2], rym[2], rxp[2], ryp[2];
+    Quadrature q = { nx, ny, ux, uy, vx, vy, rxm, rym, rxp, ryp };
+
+    for (int k = 0; k < count; k++) {
+      int face = faces[k];
+      int minus = faceIDs[face].first;
+      int plus  = faceIDs[face].second;
+      computeKinematics<dir>(blocks, minus, plus, halfdx, divsqrt3, q, 0);
+      Scalar fm = blocks.fixity[minus];
+      Scalar fp = blocks.fixity[plus];
+      Scalar v[6] = { blocks.vx[minus]*fm, blocks.vy[minus]*fm, blocks.wz[minus]*fm, blocks.vx[plus]*fp, blocks.vy[plus]*fp, blocks.wz[plus]*fp };
+      Scalar H[6][6] = {};
+      Scalar r[6] = {};
+      for (int j = 0; j < 2; j++) {
+	// tangent of the quadrature point in the face frame
+	Scalar un = (+ nx[j]*ux[j] + ny[j]*uy[j])*divdx;
+	Scalar ut = (- ny[j]*ux[j] + nx[j]*uy[j])*divdx;
+	Scalar kn, kt, cn, ct;
+	quadratureTangent(dir, 2*face+j, un, ut, divdx, kn, kt, cn, ct);
+
+	// rows of B (relative velocity of the quadrature point), with the columns of fixed blocks removed
+	Scalar Bx[6] = { -fm, 0.0f, +rym[j]*fm, +fp, 0.0f, -ryp[j]*fp };
+	Scalar By[6] = { 0.0f, -fm, -rxm[j]*fm, 0.0f, +fp, +rxp[j]*fp };
+
+	// G = gn n n^T + gt t t^T, and the stiffness part of the right hand side
+	Scalar gn = dt*cn + dt*dt*kn;
+	Scalar gt = dt*ct + dt*dt*kt;
+	Scalar Gxx = gn*nx[j]*nx[j] + gt*ny[j]*ny[j];
+	Scalar Gxy = (gn - gt)*nx[j]*ny[j];
+	Scalar Gyy = gn*ny[j]*ny[j] + gt*nx[j]*nx[j];
+	Scalar Bvx = 0.0;
+	Scalar Bvy = 0.0;
+	for (int c = 0; c < 6; c++) {
+	  Bvx += Bx[c]*v[c];
+	  Bvy += By[c]*v[c];
+	} // for c = ...
+	Scalar Bvn = + nx[j]*Bvx + ny[j]*Bvy;
+	Scalar Bvt = - ny[j]*Bvx + nx[j]*Bvy;
+	Scalar Kvx = dt*dt*(kn*Bvn*nx[j] - kt*Bvt*ny[j]);
+	Scalar Kvy = dt*dt*(kn*Bvn*ny[j] + kt*Bvt*nx[j]);
+	for (int a = 0; a < 6; a++) {
+	  Scalar GBx = Gxx*Bx[a] + Gxy*By[a];
+	  Scalar GBy = Gxy*Bx[a] + Gyy*By[a];
+	  for (int c = 0; c < 6; c++) H[a][c] += GBx*Bx[c] + GBy*By[c];
+	  r[a] -= Bx[a]*Kvx + By[a]*Kvy;
+	} // for a = ...
+      } // for j = ...
+
+      // add the 3x3 blocks (minus,minus), (minus,plus), (plus,minus) and (plus,plus)
+      int ids[2] = { minus, plus };
+      for (int m = 0; m < 2; m++) {
+	for (int n = 0; n < 2; n++) {
+	  Scalar* a = A.block(ids[m], ids[n]);
+	  for (int i = 0; i < 3; i++) {
+	    for (int j = 0; j < 3; j++) a[3*i+j] += H[3*m+i][3*n+j];
+	  } // for i = ...
+	} // for n = ...
+	for (int i = 0; i < 3; i++) b[3*ids[m]+i] += r[3*m+i];
+      } // for m = ...
+    } // for k = ...
+  } // assembleTangent()
+
+  // evaluate a constitutive kernel over an array of quadrature points
+  template <class Kernel>
+  static void evaluateTraction(Kernel traction, Scalar* ux, Scalar* uy, Scalar* vx, Scalar* vy, Scalar* nx, Scalar* ny, Scalar* tx, Scalar* ty, int size, const int* ids) {
+    for (int i = 0; i < size; i++) {
+      traction(ids[i], ux[i], uy[i], vx[i], vy[i], nx[i], ny[i], tx[i], ty[i]);
+    } // for i = ...
+  } // evaluateTraction()
+
+  // compute the relative displacements, velocities, normals and moment arms at
+  // quadrature points j and j+1 of the face between blocks minus and plus
+  template <Orientation dir>
+  static inline void computeKinematics(Blocks& blocks, int minus, int plus, Scalar halfdx, Scalar divsqrt3, Quadrature& q, int j) {
+    if (dir == Orientation::X) {
+      int left  = minus;
+      int right = plus;
 
       // -----o . . . . . o-----
       // #####|   2 x     |#####
@@ -59,81 +422,63 @@ public:
       // #####|   1 x     |#####
       // -----o . . . . . o-----
 
-      // compute the sin and cos of the left- and right- block rotations
-      float sinl_halfdx = sin(blocks.rz[left])*halfdx;
-      float cosl_halfdx = cos(blocks.rz[left])*halfdx;
-      float sinr_halfdx = sin(blocks.rz[right])*halfdx;
-      float cosr_halfdx = cos(blocks.rz[right])*halfdx;
+      // load the sin and cos of the left- and right- block rotations
+      Scalar sinl = blocks.sz[left];
+      Scalar cosl = blocks.cz[left];
+      Scalar sinr = blocks.sz[right];
+      Scalar cosr = blocks.cz[right];
+      Scalar sinl_halfdx = sinl*halfdx;
+      Scalar cosl_halfdx = cosl*halfdx;
+      Scalar sinr_halfdx = sinr*halfdx;
+      Scalar cosr_halfdx = cosr*halfdx;
       
-      // compute the average x-face normal direction
-      float rzavg = 0.5*(blocks.rz[left]+blocks.rz[right]);
-      nx[2*i]   = cos(rzavg);
-      ny[2*i]   = sin(rzavg);
-      nx[2*i+1] = nx[2*i];
-      ny[2*i+1] = ny[2*i];
+      // compute the average x-face normal direction (the normalized sum of both orientations)
+      Scalar cosavg = cosl + cosr;
+      Scalar sinavg = sinl + sinr;
+      Scalar inorm = 1.0f/sqrt(cosavg*cosavg + sinavg*sinavg);
+      q.nx[j]   = cosavg*inorm;
+      q.ny[j]   = sinavg*inorm;
+      q.nx[j+1] = q.nx[j];
+      q.ny[j+1] = q.ny[j];
 
       // compute the quadrature point relative displacements
-      float ux0 = blocks.px[right] - blocks.px[left] - cosr_halfdx - cosl_halfdx;
-      float uy0 = blocks.py[right] - blocks.py[left] - sinr_halfdx - sinl_halfdx;
-      float diff_sin_halfdx = (sinr_halfdx - sinl_halfdx)*divsqrt3;
-      float diff_cos_halfdx = (cosr_halfdx - cosl_halfdx)*divsqrt3;
-      ux[2*i]   = ux0 + diff_sin_halfdx;
-      uy[2*i]   = uy0 - diff_cos_halfdx;
-      ux[2*i+1] = ux0 - diff_sin_halfdx;
-      uy[2*i+1] = uy0 + diff_cos_halfdx;
+      Scalar ux0 = blocks.px[right] - blocks.px[left] - cosr_halfdx - cosl_halfdx;
+      Scalar uy0 = blocks.py[right] - blocks.py[left] - sinr_halfdx - sinl_halfdx;
+      Scalar diff_sin_halfdx = (sinr_halfdx - sinl_halfdx)*divsqrt3;
+      Scalar diff_cos_halfdx = (cosr_halfdx - cosl_halfdx)*divsqrt3;
+      q.ux[j]   = ux0 + diff_sin_halfdx;
+      q.uy[j]   = uy0 - diff_cos_halfdx;
+      q.ux[j+1] = ux0 - diff_sin_halfdx;
+      q.uy[j+1] = uy0 + diff_cos_halfdx;
 
       // compute the time-rates for sin and cos of the left- and right- block rotations
-      float dsinl_halfdx = +cosl_halfdx*blocks.wz[left];
-      float dcosl_halfdx = -sinl_halfdx*blocks.wz[left];
-      float dsinr_halfdx = +cosr_halfdx*blocks.wz[right];
-      float dcosr_halfdx = -sinr_halfdx*blocks.wz[right];
+      Scalar dsinl_halfdx = +cosl_halfdx*blocks.wz[left];
+      Scalar dcosl_halfdx = -sinl_halfdx*blocks.wz[left];
+      Scalar dsinr_halfdx = +cosr_halfdx*blocks.wz[right];
+      Scalar dcosr_halfdx = -sinr_halfdx*blocks.wz[right];
 
       // compute the quadrature point relative velocities
-      float vx0 = blocks.vx[right] - blocks.vx[left] - dcosr_halfdx - dcosl_halfdx;
-      float vy0 = blocks.vy[right] - blocks.vy[left] - dsinr_halfdx - dsinl_halfdx;
-      float diff_dsin_halfdx = (dsinr_halfdx - dsinl_halfdx)*divsqrt3;
-      float diff_dcos_halfdx = (dcosr_halfdx - dcosl_halfdx)*divsqrt3;
-      vx[2*i]   = vx0 + diff_dsin_halfdx;
-      vy[2*i]   = vy0 - diff_dcos_halfdx;
-      vx[2*i+1] = vx0 - diff_dsin_halfdx;
-      vy[2*i+1] = vy0 + diff_dcos_halfdx;
+      Scalar vx0 = blocks.vx[right] - blocks.vx[left] - dcosr_halfdx - dcosl_halfdx;
+      Scalar vy0 = blocks.vy[right] - blocks.vy[left] - dsinr_halfdx - dsinl_halfdx;
+      Scalar diff_dsin_halfdx = (dsinr_halfdx - dsinl_halfdx)*divsqrt3;
+      Scalar diff_dcos_halfdx = (dcosr_halfdx - dcosl_halfdx)*divsqrt3;
+      q.vx[j]   = vx0 + diff_dsin_halfdx;
+      q.vy[j]   = vy0 - diff_dcos_halfdx;
+      q.vx[j+1] = vx0 - diff_dsin_halfdx;
+      q.vy[j+1] = vy0 + diff_dcos_halfdx;
 
       // compute the moment arms relative to the left- and right- blocks
-      rxm[2*i]   = + cosl_halfdx + sinl_halfdx*divsqrt3 + 0.5*ux[2*i];
-      rym[2*i]   = + sinl_halfdx - cosl_halfdx*divsqrt3 + 0.5*uy[2*i];
-      rxm[2*i+1] = + cosl_halfdx - sinl_halfdx*divsqrt3 + 0.5*ux[2*i+1];
-      rym[2*i+1] = + sinl_halfdx + cosl_halfdx*divsqrt3 + 0.5*uy[2*i+1];
-      rxp[2*i]   = - cosr_halfdx + sinr_halfdx*divsqrt3 - 0.5*ux[2*i];
-      ryp[2*i]   = - sinr_halfdx - cosr_halfdx*divsqrt3 - 0.5*uy[2*i];
-      rxp[2*i+1] = - cosr_halfdx - sinr_halfdx*divsqrt3 - 0.5*ux[2*i+1];
-      ryp[2*i+1] = - sinr_halfdx + cosr_halfdx*divsqrt3 - 0.5*uy[2*i+1];
-    } // for i = ...
-
-    // compute the cohesive traction vectors at each quadrature point
-    computeTraction(ux,uy,vx,vy,nx,ny,tx,ty,divdx,Orientation::X,2*xFaceIDs.size());
-
-    // loop over all x-faces
-    for (int i = 0; i < xFaceIDs.size(); i++) {
-      // get the global block ids of the current x-face
-      int left  = xFaceIDs[i].first;
-      int right = xFaceIDs[i].second;
-
-      // sum the cohesive tractions to the applied block forces
-      float fx = (tx[2*i] + tx[2*i+1])*dx;
-      float fy = (ty[2*i] + ty[2*i+1])*dx;
-      blocks.fx[left]  += fx;
-      blocks.fy[left]  += fy;
-      blocks.fx[right] -= fx;
-      blocks.fy[right] -= fy;
-      blocks.mz[left]  += (rxm[2*i]*ty[2*i] - rym[2*i]*tx[2*i] + rxm[2*i+1]*ty[2*i+1] - rym[2*i+1]*tx[2*i+1])*halfdx;
-      blocks.mz[right] -= (rxp[2*i]*ty[2*i] - ryp[2*i]*tx[2*i] + rxp[2*i+1]*ty[2*i+1] - ryp[2*i+1]*tx[2*i+1])*halfdx;
-    } // for i = ...
-
-    // loop over all y-faces
-    for (int i = 0; i < yFaceIDs.size(); i++) {
-      // get the global block ids of the current y-face
-      int lower = yFaceIDs[i].first;
-      int upper = yFaceIDs[i].second;
+      q.rxm[j]   = + cosl_halfdx + sinl_halfdx*divsqrt3 + 0.5*q.ux[j];
+      q.rym[j]   = + sinl_halfdx - cosl_halfdx*divsqrt3 + 0.5*q.uy[j];
+      q.rxm[j+1] = + cosl_halfdx - sinl_halfdx*divsqrt3 + 0.5*q.ux[j+1];
+      q.rym[j+1] = + sinl_halfdx + cosl_halfdx*divsqrt3 + 0.5*q.uy[j+1];
+      q.rxp[j]   = - cosr_halfdx + sinr_halfdx*divsqrt3 - 0.5*q.ux[j];
+      q.ryp[j]   = - sinr_halfdx - cosr_halfdx*divsqrt3 - 0.5*q.uy[j];
+      q.rxp[j+1] = - cosr_halfdx - sinr_halfdx*divsqrt3 - 0.5*q.ux[j+1];
+      q.ryp[j+1] = - sinr_halfdx + cosr_halfdx*divsqrt3 - 0.5*q.uy[j+1];
+    } else { // if (dir == Orientation::Y)
+      int lower = minus;
+      int upper = plus;
 
       // -----o . . . . . o-----
       // #####|   2 x     |#####
@@ -141,112 +486,162 @@ public:
       // #####|   1 x     |#####
       // -----o . . . . . o-----
 
-      // compute the sin and cos of the lower- and upper- block rotations
-      float sinl_halfdx = sin(blocks.rz[lower])*halfdx;
-      float cosl_halfdx = cos(blocks.rz[lower])*halfdx;
-      float sinu_halfdx = sin(blocks.rz[upper])*halfdx;
-      float cosu_halfdx = cos(blocks.rz[upper])*halfdx;
+      // load the sin and cos of the lower- and upper- block rotations
+      Scalar sinl = blocks.sz[lower];
+      Scalar cosl = blocks.cz[lower];
+      Scalar sinu = blocks.sz[upper];
+      Scalar cosu = blocks.cz[upper];
+      Scalar sinl_halfdx = sinl*halfdx;
+      Scalar cosl_halfdx = cosl*halfdx;
+      Scalar sinu_halfdx = sinu*halfdx;
+      Scalar cosu_halfdx = cosu*halfdx;
 
-      // compute the average y-face normal direction
-      float rzavg = 0.5*(blocks.rz[lower]+blocks.rz[upper]);
-      nx[2*i]   =-sin(rzavg);
-      ny[2*i]   = cos(rzavg);
-      nx[2*i+1] = nx[2*i];
-      ny[2*i+1] = ny[2*i];
+      // compute the average y-face normal direction (the normalized sum of both orientations, rotated by 90 degrees)
+      Scalar cosavg = cosl + cosu;
+      Scalar sinavg = sinl + sinu;
+      Scalar inorm = 1.0f/sqrt(cosavg*cosavg + sinavg*sinavg);
+      q.nx[j]   =-sinavg*inorm;
+      q.ny[j]   = cosavg*inorm;
+      q.nx[j+1] = q.nx[j];
+      q.ny[j+1] = q.ny[j];
 
       // compute the quadrature point relative displacements
-      float ux0 = blocks.px[upper] - blocks.px[lower] + sinu_halfdx + sinl_halfdx;
-      float uy0 = blocks.py[upper] - blocks.py[lower] - cosu_halfdx - cosl_halfdx;
-      float diff_sin_halfdx = (sinu_halfdx - sinl_halfdx)*divsqrt3;
-      float diff_cos_halfdx = (cosu_halfdx - cosl_halfdx)*divsqrt3;
-      ux[2*i]   = ux0 + diff_cos_halfdx;
-      uy[2*i]   = uy0 + diff_sin_halfdx;
-      ux[2*i+1] = ux0 - diff_cos_halfdx;
-      uy[2*i+1] = uy0 - diff_sin_halfdx;
+      Scalar ux0 = blocks.px[upper] - blocks.px[lower] + sinu_halfdx + sinl_halfdx;
+      Scalar uy0 = blocks.py[upper] - blocks.py[lower] - cosu_halfdx - cosl_halfdx;
+      Scalar diff_sin_halfdx = (sinu_halfdx - sinl_halfdx)*divsqrt3;
+      Scalar diff_cos_halfdx = (cosu_halfdx - cosl_halfdx)*divsqrt3;
+      q.ux[j]   = ux0 + diff_cos_halfdx;
+      q.uy[j]   = uy0 + diff_sin_halfdx;
+      q.ux[j+1] = ux0 - diff_cos_halfdx;
+      q.uy[j+1] = uy0 - diff_sin_halfdx;
 
       // compute the time-rates for sin and cos of the lower- and upper- block rotations
-      float dsinl_halfdx = +cosl_halfdx*blocks.wz[lower];
-      float dcosl_halfdx = -sinl_halfdx*blocks.wz[lower];
-      float dsinu_halfdx = +cosu_halfdx*blocks.wz[upper];
-      float dcosu_halfdx = -sinu_halfdx*blocks.wz[upper];
+      Scalar dsinl_halfdx = +cosl_halfdx*blocks.wz[lower];
+      Scalar dcosl_halfdx = -sinl_halfdx*blocks.wz[lower];
+      Scalar dsinu_halfdx = +cosu_halfdx*blocks.wz[upper];
+      Scalar dcosu_halfdx = -sinu_halfdx*blocks.wz[upper];
 
       // compute the quadrature point relative velocities
-      float vx0 = blocks.vx[upper] - blocks.vx[lower] + dsinu_halfdx + dsinl_halfdx;
-      float vy0 = blocks.vy[upper] - blocks.vy[lower] - dcosu_halfdx - dcosl_halfdx;
-      float diff_dsin_halfdx = (dsinu_halfdx - dsinl_halfdx)*divsqrt3;
-      float diff_dcos_halfdx = (dcosu_halfdx - dcosl_halfdx)*divsqrt3;
-      vx[2*i]   = vx0 + diff_dcos_halfdx;
-      vy[2*i]   = vy0 + diff_dsin_halfdx;
-      vx[2*i+1] = vx0 - diff_dcos_halfdx;
-      vy[2*i+1] = vy0 - diff_dsin_halfdx;
+      Scalar vx0 = blocks.vx[upper] - blocks.vx[lower] + dsinu_halfdx + dsinl_halfdx;
+      Scalar vy0 = blocks.vy[upper] - blocks.vy[lower] - dcosu_halfdx - dcosl_halfdx;
+      Scalar diff_dsin_halfdx = (dsinu_halfdx - dsinl_halfdx)*divsqrt3;
+      Scalar diff_dcos_halfdx = (dcosu_halfdx - dcosl_halfdx)*divsqrt3;
+      q.vx[j]   = vx0 + diff_dcos_halfdx;
+      q.vy[j]   = vy0 + diff_dsin_halfdx;
+      q.vx[j+1] = vx0 - diff_dcos_halfdx;
+      q.vy[j+1] = vy0 - diff_dsin_halfdx;
 
       // compute the moment arms relative to the lower- and upper- blocks
-      rxm[2*i]   = - sinl_halfdx + cosl_halfdx*divsqrt3 + 0.5*ux[2*i];
-      rym[2*i]   = + cosl_halfdx + sinl_halfdx*divsqrt3 + 0.5*uy[2*i];
-      rxm[2*i+1] = - sinl_halfdx - cosl_halfdx*divsqrt3 + 0.5*ux[2*i+1];
-      rym[2*i+1] = + cosl_halfdx - sinl_halfdx*divsqrt3 + 0.5*uy[2*i+1];
-      rxp[2*i]   = + sinu_halfdx + cosu_halfdx*divsqrt3 - 0.5*ux[2*i];
-      ryp[2*i]   = - cosu_halfdx + sinu_halfdx*divsqrt3 - 0.5*uy[2*i];
-      rxp[2*i+1] = + sinu_halfdx - cosu_halfdx*divsqrt3 - 0.5*ux[2*i+1];
-      ryp[2*i+1] = - cosu_halfdx - sinu_halfdx*divsqrt3 - 0.5*uy[2*i+1];
-    } // for i = ...
+      q.rxm[j]   = - sinl_halfdx + cosl_halfdx*divsqrt3 + 0.5*q.ux[j];
+      q.rym[j]   = + cosl_halfdx + sinl_halfdx*divsqrt3 + 0.5*q.uy[j];
+      q.rxm[j+1] = - sinl_halfdx - cosl_halfdx*divsqrt3 + 0.5*q.ux[j+1];
+      q.rym[j+1] = + cosl_halfdx - sinl_halfdx*divsqrt3 + 0.5*q.uy[j+1];
+      q.rxp[j]   = + sinu_halfdx + cosu_halfdx*divsqrt3 - 0.5*q.ux[j];
+      q.ryp[j]   = - cosu_halfdx + sinu_halfdx*divsqrt3 - 0.5*q.uy[j];
+      q.rxp[j+1] = + sinu_halfdx - cosu_halfdx*divsqrt3 - 0.5*q.ux[j+1];
+      q.ryp[j+1] = - cosu_halfdx - sinu_halfdx*divsqrt3 - 0.5*q.uy[j+1];
+    } // check X/Y-face orientation
+  } // computeKinematics()
 
-    // compute the cohesive traction vectors at each quadrature point
-    computeTraction(ux,uy,vx,vy,nx,ny,tx,ty,divdx,Orientation::Y,2*yFaceIDs.size());
-
-    // loop over all y-faces
-    for (int i = 0; i < yFaceIDs.size(); i++) {
-      // get the global block ids of the current y-face
-      int lower = yFaceIDs[i].first;
-      int upper = yFaceIDs[i].second;
-
-      // and sum the cohesive tractions to the applied block forces
-      float fx = (tx[2*i] + tx[2*i+1])*dx;
-      float fy = (ty[2*i] + ty[2*i+1])*dx;
-      blocks.fx[lower] += fx;
-      blocks.fy[lower] += fy;
-      blocks.fx[upper] -= fx;
-      blocks.fy[upper] -= fy;
-      blocks.mz[lower] += (rxm[2*i]*ty[2*i] - rym[2*i]*tx[2*i] + rxm[2*i+1]*ty[2*i+1] - rym[2*i+1]*tx[2*i+1])*halfdx;
-      blocks.mz[upper] -= (rxp[2*i]*ty[2*i] - ryp[2*i]*tx[2*i] + rxp[2*i+1]*ty[2*i+1] - ryp[2*i+1]*tx[2*i+1])*halfdx;
-    } // for i = ...
+  // multi-rate weight of the force of the face between blocks minus and plus: the face is stepped at the finer
+  // level of its blocks, every 2^(finestLevel-level) substeps, so its force is applied for that many substeps
+  // (the blocks sum their forces until their own step, see Blocks::timeIntegrate)
+  static inline Scalar levelWeight(const Blocks& blocks, int minus, int plus) {
+    if (blocks.finestLevel == 0) return 1.0;
+    return Scalar(1 << (blocks.finestLevel - std::max(blocks.level[minus], blocks.level[plus])));
+  } // levelWeight()
+
+  // sum the cohesive tractions at quadrature points j and j+1 (times weight) to the applied forces of blocks minus and plus
+  static inline void scatterForces(Blocks& blocks, int minus, int plus, const Quadrature& q, const Scalar* tx, const Scalar* ty, int j, Scalar dx, Scalar halfdx, Scalar weight) {
+    Scalar fx = (tx[j] + tx[j+1])*dx*weight;
+    Scalar fy = (ty[j] + ty[j+1])*dx*weight;
+    blocks.fx[minus] += fx;
+    blocks.fy[minus] += fy;
+    blocks.fx[plus]  -= fx;
+    blocks.fy[plus]  -= fy;
+    blocks.mz[minus] += (q.rxm[j]*ty[j] - q.rym[j]*tx[j] + q.rxm[j+1]*ty[j+1] - q.rym[j+1]*tx[j+1])*halfdx*weight;
+    blocks.mz[plus]  -= (q.rxp[j]*ty[j] - q.ryp[j]*tx[j] + q.rxp[j+1]*ty[j+1] - q.ryp[j+1]*tx[j+1])*halfdx*weight;
+  } // scatterForces()
+
+  // store the cohesive forces and moments of a face (from quadrature points j and j+1, times weight) in a face force buffer
+  static inline void storeForces(const FaceForces& out, int face, const Quadrature& q, const Scalar* tx, const Scalar* ty, int j, Scalar dx, Scalar halfdx, Scalar weight) {
+    out.fx[face] = (tx[j] + tx[j+1])*dx*weight;
+    out.fy[face] = (ty[j] + ty[j+1])*dx*weight;
+    out.mzMinus[face] = (q.rxm[j]*ty[j] - q.rym[j]*tx[j] + q.rxm[j+1]*ty[j+1] - q.rym[j+1]*tx[j+1])*halfdx*weight;
+    out.mzPlus[face]  = (q.rxp[j]*ty[j] - q.ryp[j]*tx[j] + q.rxp[j+1]*ty[j+1] - q.ryp[j+1]*tx[j+1])*halfdx*weight;
+  } // storeForces()
 
-  } // applyForces()
-  
   std::vector<std::pair<int,int> > xFaceIDs;
   std::vector<std::pair<int,int> > yFaceIDs;
+  std::vector<int> xColor[2]; // active x-face indices of each color
+  std::vector<int> yColor[2]; // active y-face indices of each color
+  std::vector<int> xLevelCount[2]; // number of awake x-faces of each color at each multi-rate level or finer
+  std::vector<int> yLevelCount[2];
+  std::vector<Workspace> workspace; // one per thread
+  bool chunked = false; // use the chunked rather than the fused face pass
+  bool gather = false;  // store face forces in forces[dir] rather than scattering them to the blocks
+  FaceForces forces[2] = {}; // face force buffers of the x- and y-faces (gather assembly)
+  std::atomic<bool> pendingFailure{false}; // a face may have failed since the last compaction
 }; // CohesiveZone
-
 class KelvinVoigt : public CohesiveZone {
 public:
   
-  KelvinVoigt(float newStiffness, float newViscosity) {
+  KelvinVoigt(Scalar newStiffness, Scalar newViscosity) {
     stiffness = newStiffness;
     viscosity = newViscosity;
   } // KelvinVoigt()
 
   virtual void initialize(void) { } // initialize()
 
-  virtual void computeTraction(float* ux, float* uy, float* vx, float* vy, float* nx, float* ny, float* tx, float* ty, float divdx, Orientation dir, int size) {
-    // pre-compute material constants, adjusted by length scale (and possibly initial orientation)
-    float Edivdx   = stiffness*divdx;
-    float etadivdx = viscosity*divdx;
+  // point-wise constitutive kernel, shared by the fused and the chunked face passes
+  struct Kernel {
+    Kernel(KelvinVoigt& law, Orientation dir, Scalar divdx) {
+      // pre-compute material constants, adjusted by length scale (and possibly initial orientation)
+      Edivdx   = law.stiffness*divdx;
+      etadivdx = law.viscosity*divdx;
+    } // Kernel()
 
-    // loop over all quadrature points
-    for (int i = 0; i < size; i++) {
-      tx[i] = Edivdx*ux[i] + etadivdx*vx[i];
-      ty[i] = Edivdx*uy[i] + etadivdx*vy[i];
-    } // for i = ...
+    inline void operator()(int i, Scalar ux, Scalar uy, Scalar vx, Scalar vy, Scalar nx, Scalar ny, Scalar& tx, Scalar& ty) {
+      tx = Edivdx*ux + etadivdx*vx;
+      ty = Edivdx*uy + etadivdx*vy;
+    } // operator()
+
+    Scalar Edivdx;
+    Scalar etadivdx;
+  }; // Kernel
+
+  virtual void applyFusedForces(Blocks& blocks, Orientation dir, const int* faces, int count) {
+    fusedForces<KelvinVoigt>(blocks, dir, faces, count);
+  } // applyFusedForces()
+
+  virtual void faceStiffness(Orientation dir, int face, Scalar& faceStiffness, Scalar& faceViscosity) {
+    faceStiffness = 2.0*stiffness;
+    faceViscosity = 2.0*viscosity;
+  } // faceStiffness()
+
+  virtual void quadratureTangent(Orientation dir, int qp, Scalar un, Scalar ut, Scalar divdx, Scalar& kn, Scalar& kt, Scalar& cn, Scalar& ct) {
+    kn = stiffness;
+    kt = stiffness;
+    cn = viscosity;
+    ct = viscosity;
+  } // quadratureTangent()
+
+  virtual Scalar elasticStrength(Orientation dir, int face) {
+    return std::numeric_limits<Scalar>::max();
+  } // elasticStrength()
+
+  virtual void computeTraction(Scalar* ux, Scalar* uy, Scalar* vx, Scalar* vy, Scalar* nx, Scalar* ny, Scalar* tx, Scalar* ty, Scalar divdx, Orientation dir, int size, const int* ids) {
+    evaluateTraction(Kernel(*this,dir,divdx),ux,uy,vx,vy,nx,ny,tx,ty,size,ids);
   } // computeTraction()
   
-  float stiffness;
-  float viscosity;
+  Scalar stiffness;
+  Scalar viscosity;
 }; // KelvinVoigt
 
 class BrittleDamage : public KelvinVoigt {
 public:
   
-  BrittleDamage(float newFailureStress, float newStiffness, float newViscosity) : KelvinVoigt(newStiffness,newViscosity) {
+  BrittleDamage(Scalar newFailureStress, Scalar newStiffness, Scalar newViscosity) : KelvinVoigt(newStiffness,newViscosity) {
     failureStress = newFailureStress;
   } // BrittleDamage()
 
@@ -254,31 +649,21 @@ public:
     
   } // initialize()
 
-  virtual void computeTraction(float* ux, float* uy, float* vx, float* vy, float* nx, float* ny, float* tx, float* ty, float divdx, Orientation dir, int size) {
-    // pre-compute material constants, adjusted by length scale (and possibly initial orientation)
-    float etadivdx = viscosity*divdx;
-    float Edivdx   = stiffness*divdx;
-
-    // loop over all quadrature points
-    for (int i = 0; i < size; i++) {
-      tx[i] = Edivdx*ux[i] + etadivdx*vx[i];
-      ty[i] = Edivdx*uy[i] + etadivdx*vy[i];
-    } // for i = ...
-  } // computeTraction()
+  // (the traction is currently identical to KelvinVoigt, whose kernel is inherited)
   
-  float failureStress;
+  Scalar failureStress;
   std::vector<bool> failed;
 }; // BrittleDamage
 
 class CohesiveDamage : public KelvinVoigt {
 public:
   
-  CohesiveDamage(float newFailureStress, float newFractureEnergy, float newStiffness, float newViscosity) : KelvinVoigt(newStiffness,newViscosity) {
+  CohesiveDamage(Scalar newFailureStress, Scalar newFractureEnergy, Scalar newStiffness, Scalar newViscosity) : KelvinVoigt(newStiffness,newViscosity) {
     failureStress = newFailureStress;
     fractureEnergy = newFractureEnergy;
     failureStrain = failureStress / newStiffness;
 
-    float maxStrain = 2.0*fractureEnergy/failureStress;
+    Scalar maxStrain = 2.0*fractureEnergy/failureStress;
     if (maxStrain > failureStrain) {
       // cohesive failure, stable crack growth
       Esoftening = failureStress/(maxStrain-failureStrain);
@@ -300,76 +685,297 @@ public:
     std::fill(yFailed.begin(), yFailed.end(), 0);
   } // initialize()
 
-  virtual void computeTraction(float* ux, float* uy, float* vx, float* vy, float* nx, float* ny, float* tx, float* ty, float divdx, Orientation dir, int size) {
-    // pre-compute material constants, adjusted by length scale (and possibly initial orientation)
-    float divEdx = divdx/stiffness;
-    float etadivEdx = divEdx*viscosity;
+  // point-wise constitutive kernel, shared by the fused and the chunked face passes
+  struct Kernel {
+    Kernel(CohesiveDamage& law, Orientation dir, Scalar newDivdx) {
+      // pre-compute material constants, adjusted by length scale (and possibly initial orientation)
+      divdx = newDivdx;
+      divEdx = divdx/law.stiffness;
+      etadivEdx = divEdx*law.viscosity;
+      stiffness = law.stiffness;
+      viscosity = law.viscosity;
+      failureStress = law.failureStress;
+      failureStrain = law.failureStrain;
+      Esoftening = law.Esoftening;
+      pendingFailure = &law.pendingFailure;
 
-    // load appropriate history variables
-    float* Edamaged;
-    int*   failed;
-    if (dir == Orientation::X) {
-      Edamaged = xEdamaged.data();
-      failed = xFailed.data();
-    } else { // if (dir == Orientation::Y)
-      Edamaged = yEdamaged.data();
-      failed = yFailed.data();
-    } // check X/Y-face orientation
+      // load appropriate history variables
+      if (dir == Orientation::X) {
+	Edamaged = law.xEdamaged.data();
+	failed = law.xFailed.data();
+      } else { // if (dir == Orientation::Y)
+	Edamaged = law.yEdamaged.data();
+	failed = law.yFailed.data();
+      } // check X/Y-face orientation
+    } // Kernel()
 
-    // loop over all quadrature points
-    for (int i = 0; i < size; i++) {
+    inline void operator()(int i, Scalar ux, Scalar uy, Scalar vx, Scalar vy, Scalar nx, Scalar ny, Scalar& tx, Scalar& ty) {
       if (failed[i] == 0) {
 	// transform relative displacement (normalized by element length) into relative coordinate system
 	// with respect to the current face normal
 	// { un } = [ +nx +ny ] { ux }
 	// { ut } = [ -ny +nx ] { uy }
-	float un = (+ nx[i]*ux[i] + ny[i]*uy[i])*divdx;
-	float ut = (- ny[i]*ux[i] + nx[i]*uy[i])*divdx;
-	float vn = (+ nx[i]*vx[i] + ny[i]*vy[i])*divdx;
-	float vt = (- ny[i]*vx[i] + nx[i]*vy[i])*divdx;
+	Scalar un = (+ nx*ux + ny*uy)*divdx;
+	Scalar ut = (- ny*ux + nx*uy)*divdx;
+	Scalar vn = (+ nx*vx + ny*vy)*divdx;
+	Scalar vt = (- ny*vx + nx*vy)*divdx;
 
 	// compute the effective displacement
-	float un_tensile = fmax(0.0,un);
-	float un_compressive = un - un_tensile;
-	float u = sqrt(un_tensile*un_tensile+ut*ut);
+	Scalar un_tensile = fmax(0.0,un);
+	Scalar un_compressive = un - un_tensile;
+	Scalar u = sqrt(un_tensile*un_tensile+ut*ut);
 
 	// update the current damaged stiffness
 	Edamaged[i] = fmax(0.0,fmin(Edamaged[i],(failureStress-Esoftening*(u-failureStrain))/fmax(u,failureStrain)));
-	if (Edamaged[i] == 0.0) failed[i] = 1;
+	if (Edamaged[i] == 0.0) {
+	  failed[i] = 1;
+	  pendingFailure->store(true, std::memory_order_relaxed);
+	}
 
-	float damaged_viscosity = etadivEdx*Edamaged[i];
+	Scalar damaged_viscosity = etadivEdx*Edamaged[i];
 
 	// compute the current traction in the relative coordinate system
-	float tn = Edamaged[i]*un_tensile + damaged_viscosity*vn;
-	float tt = Edamaged[i]*ut + damaged_viscosity*vt;
+	Scalar tn = Edamaged[i]*un_tensile + damaged_viscosity*vn;
+	Scalar tt = Edamaged[i]*ut + damaged_viscosity*vt;
 	if (un_tensile == 0.0) tn += stiffness*un_compressive + viscosity*vn;
       
 	// rotate the traction into the global coordinate system
 	// { tx } = [ +nx -ny ] { tn }
 	// { ty } = [ +ny +nx ] { tt }
-	tx[i] = + nx[i]*tn - ny[i]*tt;
-	ty[i] = + ny[i]*tn + nx[i]*tt;
+	tx = + nx*tn - ny*tt;
+	ty = + ny*tn + nx*tt;
       } else {
-	tx[i] = 0.0;
-	ty[i] = 0.0;
+	tx = 0.0;
+	ty = 0.0;
       } // if (failed[i] == 0)
-    } // for i = ...
+    } // operator()
+
+    Scalar divdx;
+    Scalar divEdx;
+    Scalar etadivEdx;
+    Scalar stiffness;
+    Scalar viscosity;
+    Scalar failureStress;
+    Scalar failureStrain;
+    Scalar Esoftening;
+    Scalar* Edamaged;
+    int*   failed;
+    std::atomic<bool>* pendingFailure;
+  }; // Kernel
+
+  virtual void applyFusedForces(Blocks& blocks, Orientation dir, const int* faces, int count) {
+    fusedForces<CohesiveDamage>(blocks, dir, faces, count);
+  } // applyFusedForces()
+
+  virtual bool faceFailed(Orientation dir, int face) {
+    const int* failed = (dir == Orientation::X) ? xFailed.data() : yFailed.data();
+    return (failed[2*face] != 0) && (failed[2*face+1] != 0);
+  } // faceFailed()
+
+  virtual void faceStiffness(Orientation dir, int face, Scalar& faceStiffness, Scalar& faceViscosity) {
+    // (damage only softens the tensile response: intact quadrature points retain the full compressive stiffness)
+    const int* failed = (dir == Orientation::X) ? xFailed.data() : yFailed.data();
+    int intact = (failed[2*face] == 0) + (failed[2*face+1] == 0);
+    faceStiffness = intact*stiffness;
+    faceViscosity = intact*viscosity;
+  } // faceStiffness()
+
+  virtual void quadratureTangent(Orientation dir, int qp, Scalar un, Scalar ut, Scalar divdx, Scalar& kn, Scalar& kt, Scalar& cn, Scalar& ct) {
+    // secant stiffness of the damaged spring (closed faces respond to compression with the undamaged stiffness)
+    const Scalar* Edamaged = (dir == Orientation::X) ? xEdamaged.data() : yEdamaged.data();
+    const int* failed = (dir == Orientation::X) ? xFailed.data() : yFailed.data();
+    if (failed[qp] != 0) {
+      kn = kt = cn = ct = 0.0;
+      return;
+    }
+    kn = Edamaged[qp];
+    kt = Edamaged[qp];
+    cn = viscosity*(Edamaged[qp]/stiffness)*divdx;
+    ct = cn;
+    if (un <= 0.0) {
+      kn = stiffness;
+      cn += viscosity;
+    }
+  } // quadratureTangent()
+
+  virtual void checkpoint(Checkpoint& checkpoint) {
+    CohesiveZone::checkpoint(checkpoint);
+    checkpoint.array(xEdamaged);
+    checkpoint.array(xFailed);
+    checkpoint.array(yEdamaged);
+    checkpoint.array(yFailed);
+  } // checkpoint()
+
+  virtual Scalar elasticStrength(Orientation dir, int face) {
+    const Scalar* Edamaged = (dir == Orientation::X) ? xEdamaged.data() : yEdamaged.data();
+    bool intact = (Edamaged[2*face] == stiffness) && (Edamaged[2*face+1] == stiffness);
+    return intact ? failureStress : 0.0f;
+  } // elasticStrength()
+
+  virtual bool vectorized(void) {
+    return (simdLevel() != SimdLevel::SCALAR);
+  } // vectorized()
+
+  virtual void computeTraction(Scalar* ux, Scalar* uy, Scalar* vx, Scalar* vy, Scalar* nx, Scalar* ny, Scalar* tx, Scalar* ty, Scalar divdx, Orientation dir, int size, const int* ids) {
+    Kernel kernel(*this,dir,divdx);
+    int done = 0;
+#ifdef CZM_SIMD_X86
+    if      (simdLevel() == SimdLevel::AVX512) done = computeTractionAVX512(kernel,ux,uy,vx,vy,nx,ny,tx,ty,size,ids);
+    else if (simdLevel() == SimdLevel::AVX2)   done = computeTractionAVX2(kernel,ux,uy,vx,vy,nx,ny,tx,ty,size,ids);
+#endif
+    // evaluate the remaining quadrature points with the portable scalar kernel
+    evaluateTraction(kernel,ux+done,uy+done,vx+done,vy+done,nx+done,ny+done,tx+done,ty+done,size-done,ids+done);
   } // computeTraction()
+
+#ifdef CZM_SIMD_X86
+  // branch-free variants of Kernel::operator(), processing 8 (AVX2) or 16 (AVX-512) quadrature points at once:
+  // the failed/tensile checks become lane masks, and the history variables are only updated in active lanes.
+  // both return the number of quadrature points processed (a multiple of the vector width)
+  __attribute__((target("avx2")))
+  static int computeTractionAVX2(const Kernel& k, float* ux, float* uy, float* vx, float* vy, float* nx, float* ny, float* tx, float* ty, int size, const int* ids) {
+    float* Edamaged = k.Edamaged;
+    int*   failed   = k.failed;
+    const __m256 zero          = _mm256_setzero_ps();
+    const __m256 divdx         = _mm256_set1_ps(k.divdx);
+    const __m256 etadivEdx     = _mm256_set1_ps(k.etadivEdx);
+    const __m256 stiffness     = _mm256_set1_ps(k.stiffness);
+    const __m256 viscosity     = _mm256_set1_ps(k.viscosity);
+    const __m256 failureStress = _mm256_set1_ps(k.failureStress);
+    const __m256 failureStrain = _mm256_set1_ps(k.failureStrain);
+    const __m256 Esoftening    = _mm256_set1_ps(k.Esoftening);
+    const __m256i one          = _mm256_set1_epi32(1);
+    int i = 0;
+    for (; (i+8) <= size; i += 8) {
+      __m256 nxi = _mm256_loadu_ps(nx+i);
+      __m256 nyi = _mm256_loadu_ps(ny+i);
+      __m256 uxi = _mm256_loadu_ps(ux+i);
+      __m256 uyi = _mm256_loadu_ps(uy+i);
+      __m256 vxi = _mm256_loadu_ps(vx+i);
+      __m256 vyi = _mm256_loadu_ps(vy+i);
+      __m256i idsi = _mm256_loadu_si256((__m256i*)(ids+i));
+      __m256i failedi = _mm256_i32gather_epi32(failed,idsi,4);
+      __m256 active = _mm256_castsi256_ps(_mm256_cmpeq_epi32(failedi,_mm256_setzero_si256()));
+
+      // transform relative displacement and velocity into the face coordinate system
+      __m256 un = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(nxi,uxi),_mm256_mul_ps(nyi,uyi)),divdx);
+      __m256 ut = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(nxi,uyi),_mm256_mul_ps(nyi,uxi)),divdx);
+      __m256 vn = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(nxi,vxi),_mm256_mul_ps(nyi,vyi)),divdx);
+      __m256 vt = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(nxi,vyi),_mm256_mul_ps(nyi,vxi)),divdx);
+
+      // compute the effective displacement
+      __m256 un_tensile = _mm256_max_ps(un,zero);
+      __m256 un_compressive = _mm256_sub_ps(un,un_tensile);
+      __m256 u = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(un_tensile,un_tensile),_mm256_mul_ps(ut,ut)));
+
+      // update the current damaged stiffness (in active lanes only)
+      __m256 Eold = _mm256_i32gather_ps(Edamaged,idsi,4);
+      __m256 Etrial = _mm256_div_ps(_mm256_sub_ps(failureStress,_mm256_mul_ps(Esoftening,_mm256_sub_ps(u,failureStrain))),_mm256_max_ps(u,failureStrain));
+      __m256 E = _mm256_max_ps(_mm256_min_ps(Etrial,Eold),zero);
+      E = _mm256_blendv_ps(Eold,E,active);
+      __m256 newlyFailed = _mm256_and_ps(active,_mm256_cmp_ps(E,zero,_CMP_EQ_OQ));
+      failedi = _mm256_or_si256(failedi,_mm256_and_si256(_mm256_castps_si256(newlyFailed),one));
+      if (_mm256_movemask_ps(newlyFailed)) k.pendingFailure->store(true, std::memory_order_relaxed);
+
+      // scatter the updated history variables (AVX2 has no scatter instruction)
+      alignas(32) float Estore[8];
+      alignas(32) int   failedstore[8];
+      _mm256_store_ps(Estore,E);
+      _mm256_store_si256((__m256i*)failedstore,failedi);
+      for (int j = 0; j < 8; j++) {
+	Edamaged[ids[i+j]] = Estore[j];
+	failed[ids[i+j]] = failedstore[j];
+      } // for j = ...
+
+      // compute the current traction in the relative coordinate system
+      __m256 damaged_viscosity = _mm256_mul_ps(etadivEdx,E);
+      __m256 tn = _mm256_add_ps(_mm256_mul_ps(E,un_tensile),_mm256_mul_ps(damaged_viscosity,vn));
+      __m256 tt = _mm256_add_ps(_mm256_mul_ps(E,ut),_mm256_mul_ps(damaged_viscosity,vt));
+      __m256 compressive = _mm256_cmp_ps(un_tensile,zero,_CMP_EQ_OQ);
+      __m256 tn_contact = _mm256_add_ps(tn,_mm256_add_ps(_mm256_mul_ps(stiffness,un_compressive),_mm256_mul_ps(viscosity,vn)));
+      tn = _mm256_blendv_ps(tn,tn_contact,compressive);
+
+      // rotate the traction into the global coordinate system (zero in failed lanes)
+      _mm256_storeu_ps(tx+i,_mm256_and_ps(active,_mm256_sub_ps(_mm256_mul_ps(nxi,tn),_mm256_mul_ps(nyi,tt))));
+      _mm256_storeu_ps(ty+i,_mm256_and_ps(active,_mm256_add_ps(_mm256_mul_ps(nyi,tn),_mm256_mul_ps(nxi,tt))));
+    } // for i = ...
+    return i;
+  } // computeTractionAVX2()
+
+  CZM_AVX512_BEGIN
+  __attribute__((target("avx512f")))
+  static int computeTractionAVX512(const Kernel& k, float* ux, float* uy, float* vx, float* vy, float* nx, float* ny, float* tx, float* ty, int size, const int* ids) {
+    float* Edamaged = k.Edamaged;
+    int*   failed   = k.failed;
+    const __m512 zero          = _mm512_setzero_ps();
+    const __m512 divdx         = _mm512_set1_ps(k.divdx);
+    const __m512 etadivEdx     = _mm512_set1_ps(k.etadivEdx);
+    const __m512 stiffness     = _mm512_set1_ps(k.stiffness);
+    const __m512 viscosity     = _mm512_set1_ps(k.viscosity);
+    const __m512 failureStress = _mm512_set1_ps(k.failureStress);
+    const __m512 failureStrain = _mm512_set1_ps(k.failureStrain);
+    const __m512 Esoftening    = _mm512_set1_ps(k.Esoftening);
+    int i = 0;
+    for (; (i+16) <= size; i += 16) {
+      __m512 nxi = _mm512_loadu_ps(nx+i);
+      __m512 nyi = _mm512_loadu_ps(ny+i);
+      __m512 uxi = _mm512_loadu_ps(ux+i);
+      __m512 uyi = _mm512_loadu_ps(uy+i);
+      __m512 vxi = _mm512_loadu_ps(vx+i);
+      __m512 vyi = _mm512_loadu_ps(vy+i);
+      __m512i idsi = _mm512_loadu_si512(ids+i);
+      __m512i failedi = _mm512_i32gather_epi32(idsi,failed,4);
+      __mmask16 active = _mm512_cmpeq_epi32_mask(failedi,_mm512_setzero_si512());
+
+      // transform relative displacement and velocity into the face coordinate system
+      __m512 un = _mm512_mul_ps(_mm512_add_ps(_mm512_mul_ps(nxi,uxi),_mm512_mul_ps(nyi,uyi)),divdx);
+      __m512 ut = _mm512_mul_ps(_mm512_sub_ps(_mm512_mul_ps(nxi,uyi),_mm512_mul_ps(nyi,uxi)),divdx);
+      __m512 vn = _mm512_mul_ps(_mm512_add_ps(_mm512_mul_ps(nxi,vxi),_mm512_mul_ps(nyi,vyi)),divdx);
+      __m512 vt = _mm512_mul_ps(_mm512_sub_ps(_mm512_mul_ps(nxi,vyi),_mm512_mul_ps(nyi,vxi)),divdx);
+
+      // compute the effective displacement
+      __m512 un_tensile = _mm512_max_ps(un,zero);
+      __m512 un_compressive = _mm512_sub_ps(un,un_tensile);
+      __m512 u = _mm512_sqrt_ps(_mm512_add_ps(_mm512_mul_ps(un_tensile,un_tensile),_mm512_mul_ps(ut,ut)));
+
+      // update the current damaged stiffness (in active lanes only)
+      __m512 Eold = _mm512_i32gather_ps(idsi,Edamaged,4);
+      __m512 Etrial = _mm512_div_ps(_mm512_sub_ps(failureStress,_mm512_mul_ps(Esoftening,_mm512_sub_ps(u,failureStrain))),_mm512_max_ps(u,failureStrain));
+      __m512 E = _mm512_mask_blend_ps(active,Eold,_mm512_max_ps(_mm512_min_ps(Etrial,Eold),zero));
+      _mm512_i32scatter_ps(Edamaged,idsi,E,4);
+      __mmask16 newlyFailed = active & _mm512_cmp_ps_mask(E,zero,_CMP_EQ_OQ);
+      _mm512_mask_i32scatter_epi32(failed,newlyFailed,idsi,_mm512_set1_epi32(1),4);
+      if (newlyFailed) k.pendingFailure->store(true, std::memory_order_relaxed);
+
+      // compute the current traction in the relative coordinate system
+      __m512 damaged_viscosity = _mm512_mul_ps(etadivEdx,E);
+      __m512 tn = _mm512_add_ps(_mm512_mul_ps(E,un_tensile),_mm512_mul_ps(damaged_viscosity,vn));
+      __m512 tt = _mm512_add_ps(_mm512_mul_ps(E,ut),_mm512_mul_ps(damaged_viscosity,vt));
+      __mmask16 compressive = _mm512_cmp_ps_mask(un_tensile,zero,_CMP_EQ_OQ);
+      tn = _mm512_mask_add_ps(tn,compressive,tn,_mm512_add_ps(_mm512_mul_ps(stiffness,un_compressive),_mm512_mul_ps(viscosity,vn)));
+
+      // rotate the traction into the global coordinate system (zero in failed lanes)
+      _mm512_storeu_ps(tx+i,_mm512_maskz_sub_ps(active,_mm512_mul_ps(nxi,tn),_mm512_mul_ps(nyi,tt)));
+      _mm512_storeu_ps(ty+i,_mm512_maskz_add_ps(active,_mm512_mul_ps(nyi,tn),_mm512_mul_ps(nxi,tt)));
+    } // for i = ...
+    return i;
+  } // computeTractionAVX512()
+  CZM_AVX512_END
+#endif // CZM_SIMD_X86
   
-  float failureStress;
-  float fractureEnergy;
-  float failureStrain;
-  float Esoftening;
-  std::vector<float> xEdamaged;
+  Scalar failureStress;
+  Scalar fractureEnergy;
+  Scalar failureStrain;
+  Scalar Esoftening;
+  std::vector<Scalar> xEdamaged;
   std::vector<int>   xFailed;
-  std::vector<float> yEdamaged;
+  std::vector<Scalar> yEdamaged;
   std::vector<int>   yFailed;
 }; // CohesiveDamage
 
 class Plasticity : public KelvinVoigt {
 public:
   
-  Plasticity(float newYieldStress, float newHardening, float newFailureStrain, float newStiffness, float newViscosity) : KelvinVoigt(newStiffness,newViscosity) {
+  Plasticity(Scalar newYieldStress, Scalar newHardening, Scalar newFailureStrain, Scalar newStiffness, Scalar newViscosity) : KelvinVoigt(newStiffness,newViscosity) {
     yieldStress   = newYieldStress;
     Ehardening    = newHardening;
     failureStrain = newFailureStrain;
@@ -387,41 +993,50 @@ public:
     std::fill(yPlasticSlip.begin(), yPlasticSlip.end(), 0.0);
   } // initialize()
 
-  virtual void computeTraction(float* ux, float* uy, float* vx, float* vy, float* nx, float* ny, float* tx, float* ty, float divdx, Orientation dir, int size) {
-    // load appropriate history variables
-    float* effectivePlasticSlip;
-    float* plasticSlip;
-    if (dir == Orientation::X) {
-      effectivePlasticSlip = xEffectivePlasticSlip.data();
-      plasticSlip = xPlasticSlip.data();
-    } else { // if (dir == Orientation::Y)
-      effectivePlasticSlip = yEffectivePlasticSlip.data();
-      plasticSlip = yPlasticSlip.data();
-    } // check X/Y-face orientation
+  // point-wise constitutive kernel, shared by the fused and the chunked face passes
+  struct Kernel {
+    Kernel(Plasticity& law, Orientation dir, Scalar newDivdx) {
+      divdx = newDivdx;
+      stiffness = law.stiffness;
+      viscosity = law.viscosity;
+      yieldStress = law.yieldStress;
+      Ehardening = law.Ehardening;
+      failureStrain = law.failureStrain;
+      pendingFailure = &law.pendingFailure;
 
-    // loop over all quadrature points
-    for (int i = 0; i < size; i++) {
+      // load appropriate history variables
+      if (dir == Orientation::X) {
+	effectivePlasticSlip = law.xEffectivePlasticSlip.data();
+	plasticSlip = law.xPlasticSlip.data();
+      } else { // if (dir == Orientation::Y)
+	effectivePlasticSlip = law.yEffectivePlasticSlip.data();
+	plasticSlip = law.yPlasticSlip.data();
+      } // check X/Y-face orientation
+    } // Kernel()
+
+    inline void operator()(int i, Scalar ux, Scalar uy, Scalar vx, Scalar vy, Scalar nx, Scalar ny, Scalar& tx, Scalar& ty) {
       if (effectivePlasticSlip[i] < failureStrain) {
 	// transform relative displacement (normalized by element length) into relative coordinate system
 	// with respect to the current face normal
 	// { un } = [ +nx +ny ] { ux }
 	// { ut } = [ -ny +nx ] { uy }
-	float un = (+ nx[i]*ux[i] + ny[i]*uy[i])*divdx;
-	float ut = (- ny[i]*ux[i] + nx[i]*uy[i])*divdx;
-	float vn = (+ nx[i]*vx[i] + ny[i]*vy[i])*divdx;
-	float vt = (- ny[i]*vx[i] + nx[i]*vy[i])*divdx;
+	Scalar un = (+ nx*ux + ny*uy)*divdx;
+	Scalar ut = (- ny*ux + nx*uy)*divdx;
+	Scalar vn = (+ nx*vx + ny*vy)*divdx;
+	Scalar vt = (- ny*vx + nx*vy)*divdx;
 	
 	// compute the current trial elastic traction in the relative coordinate system
-	float tn = stiffness*un;
-	float tt = stiffness*(ut - plasticSlip[i]);
+	Scalar tn = stiffness*un;
+	Scalar tt = stiffness*(ut - plasticSlip[i]);
 
 	// check for yielding and conditionally update the plastic slip
 	// fy = fy_trial - (slip_dir*stiffness + Ehardening)*dSlip <= 0
-	float fy_trial = fabs(tt) - (yieldStress + Ehardening*plasticSlip[i]);
-	float slip_dir = (tt > 0.0) ? +1.0 : -1.0;
-	float dSlip = fmax(fy_trial,0.0)/(slip_dir*stiffness+Ehardening);
+	Scalar fy_trial = fabs(tt) - (yieldStress + Ehardening*plasticSlip[i]);
+	Scalar slip_dir = (tt > 0.0) ? +1.0 : -1.0;
+	Scalar dSlip = fmax(fy_trial,0.0)/(slip_dir*stiffness+Ehardening);
 	plasticSlip[i] += dSlip;
 	effectivePlasticSlip[i] += fabs(dSlip);
+	if (effectivePlasticSlip[i] >= failureStrain) pendingFailure->store(true, std::memory_order_relaxed);
 
 	// update the post-yielding traction and include the viscous traction contribution
 	tn += viscosity*vn;
@@ -430,22 +1045,222 @@ public:
 	// rotate the traction into the global coordinate system
 	// { tx } = [ +nx -ny ] { tn }
 	// { ty } = [ +ny +nx ] { tt }
-	tx[i] = + nx[i]*tn - ny[i]*tt;
-	ty[i] = + ny[i]*tn + nx[i]*tt;
+	tx = + nx*tn - ny*tt;
+	ty = + ny*tn + nx*tt;
       } else {
-	tx[i] = 0.0;
-	ty[i] = 0.0;
+	tx = 0.0;
+	ty = 0.0;
       } // if (failed)
-    } // for i = ...
+    } // operator()
+
+    Scalar divdx;
+    Scalar stiffness;
+    Scalar viscosity;
+    Scalar yieldStress;
+    Scalar Ehardening;
+    Scalar failureStrain;
+    Scalar* effectivePlasticSlip;
+    Scalar* plasticSlip;
+    std::atomic<bool>* pendingFailure;
+  }; // Kernel
+
+  virtual void applyFusedForces(Blocks& blocks, Orientation dir, const int* faces, int count) {
+    fusedForces<Plasticity>(blocks, dir, faces, count);
+  } // applyFusedForces()
+
+  virtual bool faceFailed(Orientation dir, int face) {
+    const Scalar* effectivePlasticSlip = (dir == Orientation::X) ? xEffectivePlasticSlip.data() : yEffectivePlasticSlip.data();
+    return (effectivePlasticSlip[2*face] >= failureStrain) && (effectivePlasticSlip[2*face+1] >= failureStrain);
+  } // faceFailed()
+
+  virtual void faceStiffness(Orientation dir, int face, Scalar& faceStiffness, Scalar& faceViscosity) {
+    // (plastic slip does not soften the elastic unloading stiffness)
+    const Scalar* effectivePlasticSlip = (dir == Orientation::X) ? xEffectivePlasticSlip.data() : yEffectivePlasticSlip.data();
+    int intact = (effectivePlasticSlip[2*face] < failureStrain) + (effectivePlasticSlip[2*face+1] < failureStrain);
+    faceStiffness = intact*stiffness;
+    faceViscosity = intact*viscosity;
+  } // faceStiffness()
+
+  virtual void quadratureTangent(Orientation dir, int qp, Scalar un, Scalar ut, Scalar divdx, Scalar& kn, Scalar& kt, Scalar& cn, Scalar& ct) {
+    // consistent tangent of the return mapping: while the trial traction lies outside the yield surface,
+    // slip continues at the hardening rate, and the tangential response softens to E H/(E+H)
+    const Scalar* effectivePlasticSlip = (dir == Orientation::X) ? xEffectivePlasticSlip.data() : yEffectivePlasticSlip.data();
+    const Scalar* plasticSlip = (dir == Orientation::X) ? xPlasticSlip.data() : yPlasticSlip.data();
+    if (effectivePlasticSlip[qp] >= failureStrain) {
+      kn = kt = cn = ct = 0.0;
+      return;
+    }
+    Scalar tt = stiffness*(ut - plasticSlip[qp]);
+    bool yielding = (fabs(tt) >= (yieldStress + Ehardening*plasticSlip[qp]));
+    kn = stiffness;
+    kt = yielding ? (stiffness*Ehardening)/(stiffness+Ehardening) : stiffness;
+    cn = viscosity;
+    ct = viscosity;
+  } // quadratureTangent()
+
+  virtual void checkpoint(Checkpoint& checkpoint) {
+    CohesiveZone::checkpoint(checkpoint);
+    checkpoint.array(xEffectivePlasticSlip);
+    checkpoint.array(xPlasticSlip);
+    checkpoint.array(yEffectivePlasticSlip);
+    checkpoint.array(yPlasticSlip);
+  } // checkpoint()
+
+  virtual Scalar elasticStrength(Orientation dir, int face) {
+    const Scalar* effectivePlasticSlip = (dir == Orientation::X) ? xEffectivePlasticSlip.data() : yEffectivePlasticSlip.data();
+    bool intact = (effectivePlasticSlip[2*face] == 0.0) && (effectivePlasticSlip[2*face+1] == 0.0);
+    return intact ? yieldStress : 0.0f;
+  } // elasticStrength()
+
+  virtual bool vectorized(void) {
+    return (simdLevel() != SimdLevel::SCALAR);
+  } // vectorized()
+
+  virtual void computeTraction(Scalar* ux, Scalar* uy, Scalar* vx, Scalar* vy, Scalar* nx, Scalar* ny, Scalar* tx, Scalar* ty, Scalar divdx, Orientation dir, int size, const int* ids) {
+    Kernel kernel(*this,dir,divdx);
+    int done = 0;
+#ifdef CZM_SIMD_X86
+    if      (simdLevel() == SimdLevel::AVX512) done = computeTractionAVX512(kernel,ux,uy,vx,vy,nx,ny,tx,ty,size,ids);
+    else if (simdLevel() == SimdLevel::AVX2)   done = computeTractionAVX2(kernel,ux,uy,vx,vy,nx,ny,tx,ty,size,ids);
+#endif
+    // evaluate the remaining quadrature points with the portable scalar kernel
+    evaluateTraction(kernel,ux+done,uy+done,vx+done,vy+done,nx+done,ny+done,tx+done,ty+done,size-done,ids+done);
   } // computeTraction()
 
-  float Ehardening;
-  float yieldStress;
-  float failureStrain;
-  std::vector<float> xEffectivePlasticSlip;
-  std::vector<float> xPlasticSlip;
-  std::vector<float> yEffectivePlasticSlip;
-  std::vector<float> yPlasticSlip;
+#ifdef CZM_SIMD_X86
+  // branch-free variants of Kernel::operator(), processing 8 (AVX2) or 16 (AVX-512) quadrature points at once:
+  // the failure and yield checks become lane masks, and the return mapping is applied in active lanes only.
+  // both return the number of quadrature points processed (a multiple of the vector width)
+  __attribute__((target("avx2")))
+  static int computeTractionAVX2(const Kernel& k, float* ux, float* uy, float* vx, float* vy, float* nx, float* ny, float* tx, float* ty, int size, const int* ids) {
+    float* effectivePlasticSlip = k.effectivePlasticSlip;
+    float* plasticSlip = k.plasticSlip;
+    const __m256 zero          = _mm256_setzero_ps();
+    const __m256 signbit       = _mm256_set1_ps(-0.0f);
+    const __m256 plusone       = _mm256_set1_ps(+1.0f);
+    const __m256 minusone      = _mm256_set1_ps(-1.0f);
+    const __m256 divdx         = _mm256_set1_ps(k.divdx);
+    const __m256 stiffness     = _mm256_set1_ps(k.stiffness);
+    const __m256 viscosity     = _mm256_set1_ps(k.viscosity);
+    const __m256 yieldStress   = _mm256_set1_ps(k.yieldStress);
+    const __m256 Ehardening    = _mm256_set1_ps(k.Ehardening);
+    const __m256 failureStrain = _mm256_set1_ps(k.failureStrain);
+    int i = 0;
+    for (; (i+8) <= size; i += 8) {
+      __m256 nxi = _mm256_loadu_ps(nx+i);
+      __m256 nyi = _mm256_loadu_ps(ny+i);
+      __m256 uxi = _mm256_loadu_ps(ux+i);
+      __m256 uyi = _mm256_loadu_ps(uy+i);
+      __m256 vxi = _mm256_loadu_ps(vx+i);
+      __m256 vyi = _mm256_loadu_ps(vy+i);
+      __m256i idsi = _mm256_loadu_si256((__m256i*)(ids+i));
+      __m256 eps = _mm256_i32gather_ps(effectivePlasticSlip,idsi,4);
+      __m256 slip = _mm256_i32gather_ps(plasticSlip,idsi,4);
+      __m256 active = _mm256_cmp_ps(eps,failureStrain,_CMP_LT_OQ);
+
+      // transform relative displacement and velocity into the face coordinate system
+      __m256 un = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(nxi,uxi),_mm256_mul_ps(nyi,uyi)),divdx);
+      __m256 ut = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(nxi,uyi),_mm256_mul_ps(nyi,uxi)),divdx);
+      __m256 vn = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(nxi,vxi),_mm256_mul_ps(nyi,vyi)),divdx);
+      __m256 vt = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(nxi,vyi),_mm256_mul_ps(nyi,vxi)),divdx);
+
+      // compute the trial elastic traction and the (masked) plastic slip increment
+      __m256 tn = _mm256_mul_ps(stiffness,un);
+      __m256 tt = _mm256_mul_ps(stiffness,_mm256_sub_ps(ut,slip));
+      __m256 fy_trial = _mm256_sub_ps(_mm256_andnot_ps(signbit,tt),_mm256_add_ps(yieldStress,_mm256_mul_ps(Ehardening,slip)));
+      __m256 slip_dir = _mm256_blendv_ps(minusone,plusone,_mm256_cmp_ps(tt,zero,_CMP_GT_OQ));
+      __m256 dSlip = _mm256_div_ps(_mm256_max_ps(fy_trial,zero),_mm256_add_ps(_mm256_mul_ps(slip_dir,stiffness),Ehardening));
+      dSlip = _mm256_and_ps(active,dSlip);
+      slip = _mm256_add_ps(slip,dSlip);
+      eps = _mm256_add_ps(eps,_mm256_andnot_ps(signbit,dSlip));
+      if (_mm256_movemask_ps(_mm256_and_ps(active,_mm256_cmp_ps(eps,failureStrain,_CMP_GE_OQ)))) k.pendingFailure->store(true, std::memory_order_relaxed);
+
+      // scatter the updated history variables (AVX2 has no scatter instruction)
+      alignas(32) float slipstore[8];
+      alignas(32) float epsstore[8];
+      _mm256_store_ps(slipstore,slip);
+      _mm256_store_ps(epsstore,eps);
+      for (int j = 0; j < 8; j++) {
+	plasticSlip[ids[i+j]] = slipstore[j];
+	effectivePlasticSlip[ids[i+j]] = epsstore[j];
+      } // for j = ...
+
+      // update the post-yielding traction and include the viscous traction contribution
+      tn = _mm256_add_ps(tn,_mm256_mul_ps(viscosity,vn));
+      tt = _mm256_add_ps(_mm256_mul_ps(stiffness,_mm256_sub_ps(ut,slip)),_mm256_mul_ps(viscosity,vt));
+
+      // rotate the traction into the global coordinate system (zero in failed lanes)
+      _mm256_storeu_ps(tx+i,_mm256_and_ps(active,_mm256_sub_ps(_mm256_mul_ps(nxi,tn),_mm256_mul_ps(nyi,tt))));
+      _mm256_storeu_ps(ty+i,_mm256_and_ps(active,_mm256_add_ps(_mm256_mul_ps(nyi,tn),_mm256_mul_ps(nxi,tt))));
+    } // for i = ...
+    return i;
+  } // computeTractionAVX2()
+
+  CZM_AVX512_BEGIN
+  __attribute__((target("avx512f")))
+  static int computeTractionAVX512(const Kernel& k, float* ux, float* uy, float* vx, float* vy, float* nx, float* ny, float* tx, float* ty, int size, const int* ids) {
+    float* effectivePlasticSlip = k.effectivePlasticSlip;
+    float* plasticSlip = k.plasticSlip;
+    const __m512 zero          = _mm512_setzero_ps();
+    const __m512 plusone       = _mm512_set1_ps(+1.0f);
+    const __m512 minusone      = _mm512_set1_ps(-1.0f);
+    const __m512 divdx         = _mm512_set1_ps(k.divdx);
+    const __m512 stiffness     = _mm512_set1_ps(k.stiffness);
+    const __m512 viscosity     = _mm512_set1_ps(k.viscosity);
+    const __m512 yieldStress   = _mm512_set1_ps(k.yieldStress);
+    const __m512 Ehardening    = _mm512_set1_ps(k.Ehardening);
+    const __m512 failureStrain = _mm512_set1_ps(k.failureStrain);
+    int i = 0;
+    for (; (i+16) <= size; i += 16) {
+      __m512 nxi = _mm512_loadu_ps(nx+i);
+      __m512 nyi = _mm512_loadu_ps(ny+i);
+      __m512 uxi = _mm512_loadu_ps(ux+i);
+      __m512 uyi = _mm512_loadu_ps(uy+i);
+      __m512 vxi = _mm512_loadu_ps(vx+i);
+      __m512 vyi = _mm512_loadu_ps(vy+i);
+      __m512i idsi = _mm512_loadu_si512(ids+i);
+      __m512 eps = _mm512_i32gather_ps(idsi,effectivePlasticSlip,4);
+      __m512 slip = _mm512_i32gather_ps(idsi,plasticSlip,4);
+      __mmask16 active = _mm512_cmp_ps_mask(eps,failureStrain,_CMP_LT_OQ);
+
+      // transform relative displacement and velocity into the face coordinate system
+      __m512 un = _mm512_mul_ps(_mm512_add_ps(_mm512_mul_ps(nxi,uxi),_mm512_mul_ps(nyi,uyi)),divdx);
+      __m512 ut = _mm512_mul_ps(_mm512_sub_ps(_mm512_mul_ps(nxi,uyi),_mm512_mul_ps(nyi,uxi)),divdx);
+      __m512 vn = _mm512_mul_ps(_mm512_add_ps(_mm512_mul_ps(nxi,vxi),_mm512_mul_ps(nyi,vyi)),divdx);
+      __m512 vt = _mm512_mul_ps(_mm512_sub_ps(_mm512_mul_ps(nxi,vyi),_mm512_mul_ps(nyi,vxi)),divdx);
+
+      // compute the trial elastic traction and the (masked) plastic slip increment
+      __m512 tn = _mm512_mul_ps(stiffness,un);
+      __m512 tt = _mm512_mul_ps(stiffness,_mm512_sub_ps(ut,slip));
+      __m512 fy_trial = _mm512_sub_ps(_mm512_abs_ps(tt),_mm512_add_ps(yieldStress,_mm512_mul_ps(Ehardening,slip)));
+      __m512 slip_dir = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(tt,zero,_CMP_GT_OQ),minusone,plusone);
+      __m512 dSlip = _mm512_maskz_div_ps(active,_mm512_max_ps(fy_trial,zero),_mm512_add_ps(_mm512_mul_ps(slip_dir,stiffness),Ehardening));
+      slip = _mm512_add_ps(slip,dSlip);
+      _mm512_i32scatter_ps(plasticSlip,idsi,slip,4);
+      eps = _mm512_add_ps(eps,_mm512_abs_ps(dSlip));
+      _mm512_i32scatter_ps(effectivePlasticSlip,idsi,eps,4);
+      if (_mm512_mask_cmp_ps_mask(active,eps,failureStrain,_CMP_GE_OQ)) k.pendingFailure->store(true, std::memory_order_relaxed);
+
+      // update the post-yielding traction and include the viscous traction contribution
+      tn = _mm512_add_ps(tn,_mm512_mul_ps(viscosity,vn));
+      tt = _mm512_add_ps(_mm512_mul_ps(stiffness,_mm512_sub_ps(ut,slip)),_mm512_mul_ps(viscosity,vt));
+
+      // rotate the traction into the global coordinate system (zero in failed lanes)
+      _mm512_storeu_ps(tx+i,_mm512_maskz_sub_ps(active,_mm512_mul_ps(nxi,tn),_mm512_mul_ps(nyi,tt)));
+      _mm512_storeu_ps(ty+i,_mm512_maskz_add_ps(active,_mm512_mul_ps(nyi,tn),_mm512_mul_ps(nxi,tt)));
+    } // for i = ...
+    return i;
+  } // computeTractionAVX512()
+  CZM_AVX512_END
+#endif // CZM_SIMD_X86
+
+  Scalar Ehardening;
+  Scalar yieldStress;
+  Scalar failureStrain;
+  std::vector<Scalar> xEffectivePlasticSlip;
+  std::vector<Scalar> xPlasticSlip;
+  std::vector<Scalar> yEffectivePlasticSlip;
+  std::vector<Scalar> yPlasticSlip;
 }; // Plasticity
 
 #endif // COHESIVE_ZONE_H
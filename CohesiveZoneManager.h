@@ -5,12 +5,26 @@
 #include "Grid.h"
 #include "Blocks.h"
 #include "CohesiveZone.h"
+#include "ThreadPool.h"
+#include "SparseMatrix.h"
 #include <vector>
+#include <array>
 #include <map>
+#include <string>
+#include <algorithm>
+#include <limits>
 
 class CohesiveZoneManager {
 public:
 
+  CohesiveZoneManager() = default;
+  CohesiveZoneManager(const CohesiveZoneManager&) = delete;
+  CohesiveZoneManager& operator=(const CohesiveZoneManager&) = delete;
+
+  ~CohesiveZoneManager() {
+    for (auto cohesiveZone : cohesiveZones) delete cohesiveZone.second;
+  } // ~CohesiveZoneManager()
+
   void initialize(Grid& grid) {
 
     // delete existing cohesive zones
@@ -30,7 +44,7 @@ public:
 	    key = std::pair<Material*,Material*>(grid.cells[grid.Nx*j+i], grid.cells[grid.Nx*j+i-1]);
 	  }
 	  if (cohesiveZones[key] == nullptr) cohesiveZones[key] = instantiateCohesiveZoneModel(key.first, key.second);
-	  cohesiveZones[key]->insertFaceX(left,right);
+	  cohesiveZones[key]->insertFaceX(left,right,i);
 	} // if ((left >= 0) && (right >= 0))
       } // for i = ...
     } // for j = ...
@@ -48,30 +62,409 @@ public:
 	    key = std::pair<Material*,Material*>(grid.cells[grid.Nx*j+i], grid.cells[grid.Nx*(j-1)+i]);
 	  }
 	  if (cohesiveZones[key] == nullptr) cohesiveZones[key] = instantiateCohesiveZoneModel(key.first, key.second);
-	  cohesiveZones[key]->insertFaceY(lower,upper);
+	  cohesiveZones[key]->insertFaceY(lower,upper,j);
 	} // if ((lower >= 0) && (upper >= 0))
       } // for j = ...
     } // for i = ...
 
     // initialize newly generated cohesive zones
-    for (auto cohesiveZone : cohesiveZones) cohesiveZone.second->initialize();
+    for (auto cohesiveZone : cohesiveZones) {
+      cohesiveZone.second->initialize();
+      cohesiveZone.second->setThreads(pool.size());
+    } // for cohesiveZone = ...
+
+    // build the block-to-face adjacency used by the gather-based assembly
+    int Nblocks = 0;
+    for (int id : grid.blockIDs) Nblocks = std::max(Nblocks, id+1);
+    initializeAdjacency(Nblocks);
+
+    // the implicit system couples the blocks joined by a face
+    std::vector<std::pair<int,int> > pairs;
+    for (auto cohesiveZone : cohesiveZones) {
+      pairs.insert(pairs.end(), cohesiveZone.second->xFaceIDs.begin(), cohesiveZone.second->xFaceIDs.end());
+      pairs.insert(pairs.end(), cohesiveZone.second->yFaceIDs.begin(), cohesiveZone.second->yFaceIDs.end());
+    } // for cohesiveZone = ...
+    tangent.initialize(Nblocks, pairs);
 
   } // initialize()
 
-  void applyCohesiveForces(Blocks& blocks) {
-    // compute forces for each instantiated CZ type
-    for (auto cohesiveZone : cohesiveZones) cohesiveZone.second->applyForces(blocks);
+  // assign each face a slot in the global face force buffer, and list the faces of each block in CSR form
+  // (adjacencyStart[b] ... adjacencyStart[b+1]-1 index the entries of block b, each entry being 2*slot+side,
+  // with side 0 for the minus and 1 for the plus block of the face)
+  void initializeAdjacency(int Nblocks) {
+    // assign the face force buffer slots (the x-faces, then the y-faces of each CZ type)
+    std::map<CohesiveZone*,std::array<int,2> > zoneOffsets;
+    int Nfaces = 0;
+    for (auto cohesiveZone : cohesiveZones) {
+      CohesiveZone* zone = cohesiveZone.second;
+      zoneOffsets[zone][Orientation::X] = Nfaces;
+      Nfaces += zone->xFaceIDs.size();
+      zoneOffsets[zone][Orientation::Y] = Nfaces;
+      Nfaces += zone->yFaceIDs.size();
+    } // for cohesiveZone = ...
+    faceFx.assign(Nfaces, 0.0);
+    faceFy.assign(Nfaces, 0.0);
+    faceMzMinus.assign(Nfaces, 0.0);
+    faceMzPlus.assign(Nfaces, 0.0);
+    for (auto cohesiveZone : cohesiveZones) {
+      CohesiveZone* zone = cohesiveZone.second;
+      for (int dir = 0; dir < 2; dir++) {
+	int offset = zoneOffsets[zone][dir];
+	zone->forces[dir] = FaceForces{ faceFx.data()+offset, faceFy.data()+offset, faceMzMinus.data()+offset, faceMzPlus.data()+offset };
+      } // for dir = ...
+    } // for cohesiveZone = ...
+
+    // count the faces of each block
+    adjacencyStart.assign(Nblocks+1, 0);
+    for (auto cohesiveZone : cohesiveZones) {
+      for (auto face : cohesiveZone.second->xFaceIDs) { adjacencyStart[face.first+1]++; adjacencyStart[face.second+1]++; }
+      for (auto face : cohesiveZone.second->yFaceIDs) { adjacencyStart[face.first+1]++; adjacencyStart[face.second+1]++; }
+    } // for cohesiveZone = ...
+    for (int b = 0; b < Nblocks; b++) adjacencyStart[b+1] += adjacencyStart[b];
+
+    // fill in the entries in the order of the colored assembly (x-faces of color 0 and 1, then y-faces
+    // of color 0 and 1), so that the sum for each block is formed in exactly the same order by both
+    adjacency.resize(adjacencyStart[Nblocks]);
+    std::vector<int> next(adjacencyStart.begin(), adjacencyStart.end()-1);
+    for (int phase = 0; phase < 4; phase++) {
+      Orientation dir = (phase < 2) ? Orientation::X : Orientation::Y;
+      int color = phase % 2;
+      for (auto cohesiveZone : cohesiveZones) {
+	CohesiveZone* zone = cohesiveZone.second;
+	const std::vector<std::pair<int,int> >& faceIDs = (dir == Orientation::X) ? zone->xFaceIDs : zone->yFaceIDs;
+	const std::vector<int>& faces = (dir == Orientation::X) ? zone->xColor[color] : zone->yColor[color];
+	for (int face : faces) {
+	  int slot = zoneOffsets[zone][dir] + face;
+	  adjacency[next[faceIDs[face].first]++]  = 2*slot;
+	  adjacency[next[faceIDs[face].second]++] = 2*slot+1;
+	} // for face = ...
+      } // for cohesiveZone = ...
+    } // for phase = ...
+  } // initializeAdjacency()
+
+  // number of threads used to assemble the cohesive forces (n < 1: one per hardware thread)
+  void setThreads(int n) {
+    pool.resize(n);
+    for (auto cohesiveZone : cohesiveZones) cohesiveZone.second->setThreads(pool.size());
+  } // setThreads()
+
+  // apply the cohesive forces of the faces stepped at the given substep of a multi-rate coarse step: a
+  // level l is stepped every 2^(finestLevel-l) substeps, so these are the faces of level minLevel or finer
+  void applyCohesiveForces(Blocks& blocks, int substep = 0) {
+    minLevel = blocks.finestLevel;
+    for (int s = substep; (minLevel > 0) && ((s & 1) == 0); s >>= 1) minLevel--;
+
+    // select the face pass for each instantiated CZ type
+    for (auto cohesiveZone : cohesiveZones) {
+      cohesiveZone.second->chunked = (kernel == ForceKernel::CHUNKED) || ((kernel == ForceKernel::AUTO) && cohesiveZone.second->vectorized());
+      cohesiveZone.second->gather = (assembly == Assembly::GATHER);
+    } // for cohesiveZone = ...
+
+    if (assembly == Assembly::GATHER) {
+      gatherCohesiveForces(blocks);
+    } else {
+      scatterCohesiveForces(blocks);
+    }
+
+    // drop faces that have failed during this pass from the face lists, and hand the
+    // blocks they joined over to block-to-block contact
+    failedFaces.clear();
+    for (auto cohesiveZone : cohesiveZones) {
+      if (cohesiveZone.second->pendingFailure.load(std::memory_order_relaxed)) {
+	cohesiveZone.second->compactFaces(failedFaces);
+	cohesiveZone.second->sortFaces(blocks);
+      }
+    } // for cohesiveZone = ...
+    for (auto face : failedFaces) blocks.breakBond(face.first, face.second);
   } // applyCohesiveForces()
 
+  // critical time step of the explicit integrator at each block, for the current state of its faces: each quadrature point
+  // acts as a spring k and dashpot c between two blocks, at a distance r (r^2 = L^2/3) from both block centers
+  // (its moment being integrated with half the weight of its force). A Gershgorin bound on M^-1 K gives the
+  // highest frequency at block i as
+  //   omega_i^2 <= sum_faces k (w_i + sqrt(w_i w_j)), with w = 1/m + r^2/(2I) (and w = 0 for fixed blocks),
+  // and the same sum over c bounds the damping rate 2 zeta omega of that mode. The critical step of the
+  // explicit scheme (velocity-lagged damping) is then dt = (2/omega)(sqrt(1+zeta^2)-zeta); the single-rate
+  // critical step is the smallest of these
+  void estimateTimeSteps(Blocks& blocks) {
+    blockStiffness.assign(blocks.Nblocks, 0.0);
+    blockViscosity.assign(blocks.Nblocks, 0.0);
+    Scalar r2 = blocks.L*blocks.L/3.0;
+    for (auto cohesiveZone : cohesiveZones) {
+      CohesiveZone* zone = cohesiveZone.second;
+      for (int phase = 0; phase < 4; phase++) {
+	Orientation dir = (phase < 2) ? Orientation::X : Orientation::Y;
+	const std::vector<std::pair<int,int> >& faceIDs = (dir == Orientation::X) ? zone->xFaceIDs : zone->yFaceIDs;
+	const std::vector<int>& faces = (dir == Orientation::X) ? zone->xColor[phase%2] : zone->yColor[phase%2];
+	for (int face : faces) {
+	  Scalar k, c;
+	  zone->faceStiffness(dir, face, k, c);
+	  int minus = faceIDs[face].first;
+	  int plus  = faceIDs[face].second;
+	  Scalar wm = blocks.fixity[minus]*(blocks.imass[minus] + 0.5*r2*blocks.iinertia[minus]);
+	  Scalar wp = blocks.fixity[plus]*(blocks.imass[plus] + 0.5*r2*blocks.iinertia[plus]);
+	  Scalar wmp = sqrt(wm*wp);
+	  blockStiffness[minus] += k*(wm + wmp);
+	  blockStiffness[plus]  += k*(wp + wmp);
+	  blockViscosity[minus] += c*(wm + wmp);
+	  blockViscosity[plus]  += c*(wp + wmp);
+	} // for face = ...
+      } // for phase = ...
+    } // for cohesiveZone = ...
+
+    blockTimeStep.assign(blocks.Nblocks, std::numeric_limits<Scalar>::max());
+    for (int i = 0; i < blocks.Nblocks; i++) {
+      if ((blocks.fixity[i] == 0.0) || (blockStiffness[i] <= 0.0)) continue;
+      Scalar omega = sqrt(blockStiffness[i]);
+      Scalar zeta = 0.5*blockViscosity[i]/omega;
+      blockTimeStep[i] = (2.0/omega)*(sqrt(1.0+zeta*zeta)-zeta);
+    } // for i = ...
+  } // estimateTimeSteps()
+
+  Scalar criticalTimeStep(Blocks& blocks) {
+    estimateTimeSteps(blocks);
+    Scalar dt = std::numeric_limits<Scalar>::max();
+    for (Scalar blockDT : blockTimeStep) dt = std::min(dt, blockDT);
+    return dt;
+  } // criticalTimeStep()
+
+  // re-sort the face lists after the multi-rate levels, sleep states or clusters of the blocks have changed
+  // (the stored forces of faces inside a cluster are cleared, since the gather assembly would keep summing them)
+  void sortFaces(Blocks& blocks) {
+    for (auto cohesiveZone : cohesiveZones) {
+      CohesiveZone* zone = cohesiveZone.second;
+      zone->sortFaces(blocks);
+      if (blocks.Nclusters == 0) continue;
+      for (int d = 0; d < 2; d++) {
+	Orientation dir = (d == 0) ? Orientation::X : Orientation::Y;
+	const std::vector<std::pair<int,int> >& faceIDs = (dir == Orientation::X) ? zone->xFaceIDs : zone->yFaceIDs;
+	if (zone->forces[dir].fx == nullptr) continue;
+	for (int face = 0; face < int(faceIDs.size()); face++) {
+	  int c = blocks.cluster[faceIDs[face].first];
+	  if ((c < 0) || (c != blocks.cluster[faceIDs[face].second])) continue;
+	  zone->forces[dir].fx[face] = 0.0;
+	  zone->forces[dir].fy[face] = 0.0;
+	  zone->forces[dir].mzMinus[face] = 0.0;
+	  zone->forces[dir].mzPlus[face] = 0.0;
+	} // for face = ...
+      } // for d = ...
+    } // for cohesiveZone = ...
+  } // sortFaces()
+
+  // list the faces that are still elastic (as pairs of blocks), with the force each can transmit before leaving
+  // the elastic regime (its elastic strength times the face length); used to form rigid clusters of blocks
+  void elasticFaces(Blocks& blocks, std::vector<std::pair<int,int> >& pairs, std::vector<Scalar>& capacities) {
+    pairs.clear();
+    capacities.clear();
+    for (auto cohesiveZone : cohesiveZones) {
+      CohesiveZone* zone = cohesiveZone.second;
+      for (int phase = 0; phase < 4; phase++) {
+	Orientation dir = (phase < 2) ? Orientation::X : Orientation::Y;
+	const std::vector<std::pair<int,int> >& faceIDs = (dir == Orientation::X) ? zone->xFaceIDs : zone->yFaceIDs;
+	const std::vector<int>& faces = (dir == Orientation::X) ? zone->xColor[phase%2] : zone->yColor[phase%2];
+	for (int face : faces) {
+	  Scalar strength = zone->elasticStrength(dir, face);
+	  if (strength <= 0.0) continue;
+	  pairs.push_back(faceIDs[face]);
+	  capacities.push_back((strength < std::numeric_limits<Scalar>::max()) ? strength*blocks.L : strength);
+	} // for face = ...
+      } // for phase = ...
+    } // for cohesiveZone = ...
+  } // elasticFaces()
+
+  // largest critical step of any block restrained by a face (from the last estimate)
+  Scalar coarsestTimeStep(void) {
+    Scalar dt = 0.0;
+    for (Scalar blockDT : blockTimeStep) {
+      if (blockDT < std::numeric_limits<Scalar>::max()) dt = std::max(dt, blockDT);
+    } // for blockDT = ...
+    return (dt > 0.0) ? dt : std::numeric_limits<Scalar>::max();
+  } // coarsestTimeStep()
+
+  // group the blocks into multi-rate levels for a coarse step coarseDT: block i is placed at the coarsest level l
+  // (at most maxLevel) whose step coarseDT/2^l is within safety times its critical step (from the last estimate),
+  // and the faces are sorted by level; returns the finest level used
+  int assignLevels(Blocks& blocks, Scalar coarseDT, Scalar safety, int maxLevel) {
+    int finestLevel = 0;
+    levels.assign(blocks.Nblocks, 0);
+    for (int i = 0; i < blocks.Nblocks; i++) {
+      Scalar levelDT = coarseDT;
+      while ((levels[i] < maxLevel) && (levelDT > safety*blockTimeStep[i])) {
+	levelDT *= 0.5;
+	levels[i]++;
+      } // while (levelDT > ...)
+      finestLevel = std::max(finestLevel, levels[i]);
+    } // for i = ...
+
+    // (the faces are only re-sorted when the levels have changed)
+    if ((finestLevel != blocks.finestLevel) || (levels != blocks.level)) {
+      blocks.level.swap(levels);
+      blocks.finestLevel = finestLevel;
+      sortFaces(blocks);
+    }
+    return finestLevel;
+  } // assignLevels()
+
+  // linearized backward Euler step: with the forces F at the start of the step applied to the blocks, solve
+  //   (M' + dt C + dt^2 K) dv = dt (W^-1 F - dt K v)
+  // for the velocity increments dv (x, y and rotation of each block), where K and C are the tangent stiffness and
+  // viscosity of all active quadrature points. The moments are integrated with half the weight of the forces
+  // (W = diag(1,1,1/2)), which is absorbed into M' = diag(m, m, 2I) so that the system remains symmetric.
+  // Fixed blocks keep dv = 0; returns the number of conjugate gradient iterations
+  int solveImplicitStep(Blocks& blocks, Scalar dt, std::vector<Scalar>& dv) {
+    tangent.zero();
+    rhs.assign(3*blocks.Nblocks, 0.0);
+
+    // add the tangents of the faces one color at a time (as in the colored force assembly)
+    for (int phase = 0; phase < 4; phase++) {
+      Orientation dir = (phase < 2) ? Orientation::X : Orientation::Y;
+      int color = phase % 2;
+      slices.clear();
+      for (auto cohesiveZone : cohesiveZones) {
+	// (faces of sleeping blocks are left out)
+	std::vector<int>& faces = (dir == Orientation::X) ? cohesiveZone.second->xColor[color] : cohesiveZone.second->yColor[color];
+	int count = cohesiveZone.second->activeCount(dir, color, 0);
+	for (int begin = 0; begin < count; begin += SLICE_SIZE) {
+	  slices.push_back(Slice{cohesiveZone.second, faces.data()+begin, std::min(SLICE_SIZE, count-begin), dir});
+	} // for begin = ...
+      } // for cohesiveZone = ...
+      pool.parallelFor(slices.size(), [&](int thread, int i) {
+	slices[i].zone->assembleTangent(blocks, slices[i].dir, slices[i].faces, slices[i].count, dt, tangent, rhs);
+      });
+    } // for phase = ...
+
+    // add the (scaled) mass matrix and the forces
+    for (int i = 0; i < blocks.Nblocks; i++) {
+      Scalar inertia = (blocks.iinertia[i] > 0.0) ? 1.0/blocks.iinertia[i] : blocks.mass[i];
+      Scalar* a = tangent.block(i,i);
+      a[0] += blocks.mass[i];
+      a[4] += blocks.mass[i];
+      a[8] += 2.0*inertia;
+      rhs[3*i]   = blocks.fixity[i]*(rhs[3*i]   + dt*blocks.fx[i]);
+      rhs[3*i+1] = blocks.fixity[i]*(rhs[3*i+1] + dt*blocks.fy[i]);
+      rhs[3*i+2] = blocks.fixity[i]*(rhs[3*i+2] + dt*2.0f*blocks.mz[i]);
+    } // for i = ...
+
+    dv.assign(3*blocks.Nblocks, 0.0);
+    return tangent.solve(rhs, dv, solverTolerance, maxSolverIterations, &pool);
+  } // solveImplicitStep()
+
+  // save or restore the state of all faces: the CZ types are visited in the order of their material names (the
+  // map itself is ordered by material address, which differs from run to run)
+  void checkpoint(Checkpoint& checkpoint) {
+    std::vector<std::pair<std::pair<std::string,std::string>,CohesiveZone*> > zones;
+    for (auto cohesiveZone : cohesiveZones) {
+      std::string first  = cohesiveZone.first.first->name;
+      std::string second = cohesiveZone.first.second->name;
+      zones.push_back(std::make_pair(std::make_pair(std::min(first,second), std::max(first,second)), cohesiveZone.second));
+    } // for cohesiveZone = ...
+    std::sort(zones.begin(), zones.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    checkpoint.match(zones.size());
+    for (auto zone : zones) zone.second->checkpoint(checkpoint);
+    checkpoint.array(blockTimeStep);
+  } // checkpoint()
+
+  // number of faces of the layout (active or failed)
+  int totalFaces(void) {
+    int count = 0;
+    for (auto cohesiveZone : cohesiveZones) count += cohesiveZone.second->xFaceIDs.size() + cohesiveZone.second->yFaceIDs.size();
+    return count;
+  } // totalFaces()
+
+  // number of faces still passed to the face kernels (faces are dropped once they have fully failed)
+  int activeFaces(void) {
+    int count = 0;
+    for (auto cohesiveZone : cohesiveZones) count += cohesiveZone.second->activeFaces();
+    return count;
+  } // activeFaces()
+
+  // colored assembly: faces of one orientation and color never share a block, so each color is assembled
+  // in parallel without atomics; the four colors are processed one after the other, which
+  // also makes the result independent of the number of threads
+  void scatterCohesiveForces(Blocks& blocks) {
+    for (int phase = 0; phase < 4; phase++) {
+      Orientation dir = (phase < 2) ? Orientation::X : Orientation::Y;
+      int color = phase % 2;
+
+      // split the face lists of all CZ types into slices of similar size
+      slices.clear();
+      for (auto cohesiveZone : cohesiveZones) {
+	std::vector<int>& faces = (dir == Orientation::X) ? cohesiveZone.second->xColor[color] : cohesiveZone.second->yColor[color];
+	int count = cohesiveZone.second->activeCount(dir, color, minLevel);
+	for (int begin = 0; begin < count; begin += SLICE_SIZE) {
+	  slices.push_back(Slice{cohesiveZone.second, faces.data()+begin, std::min(SLICE_SIZE, count-begin), dir});
+	} // for begin = ...
+      } // for cohesiveZone = ...
+
+      pool.parallelFor(slices.size(), [&](int thread, int i) {
+	slices[i].zone->applyForces(blocks, slices[i].dir, slices[i].faces, slices[i].count, thread);
+      });
+    } // for phase = ...
+  } // scatterCohesiveForces()
+
+  // gather-based assembly: the forces of all faces are computed in parallel into the face force buffer,
+  // then each block sums the forces of its own faces (in the fixed order of its adjacency list)
+  void gatherCohesiveForces(Blocks& blocks) {
+    // compute the face forces; every face writes only to its own slot, so no coloring is needed
+    slices.clear();
+    for (auto cohesiveZone : cohesiveZones) {
+      for (int phase = 0; phase < 4; phase++) {
+	Orientation dir = (phase < 2) ? Orientation::X : Orientation::Y;
+	std::vector<int>& faces = (dir == Orientation::X) ? cohesiveZone.second->xColor[phase%2] : cohesiveZone.second->yColor[phase%2];
+	int count = cohesiveZone.second->activeCount(dir, phase%2, minLevel);
+	for (int begin = 0; begin < count; begin += SLICE_SIZE) {
+	  slices.push_back(Slice{cohesiveZone.second, faces.data()+begin, std::min(SLICE_SIZE, count-begin), dir});
+	} // for begin = ...
+      } // for phase = ...
+    } // for cohesiveZone = ...
+    pool.parallelFor(slices.size(), [&](int thread, int i) {
+      slices[i].zone->applyForces(blocks, slices[i].dir, slices[i].faces, slices[i].count, thread);
+    });
+
+    // sum the face forces to the blocks
+    int Nblocks = adjacencyStart.size()-1;
+    int Nslices = (Nblocks + BLOCK_SLICE_SIZE - 1) / BLOCK_SLICE_SIZE;
+    pool.parallelFor(Nslices, [&](int thread, int slice) {
+      int end = std::min(Nblocks, (slice+1)*BLOCK_SLICE_SIZE);
+      for (int b = slice*BLOCK_SLICE_SIZE; b < end; b++) {
+	Scalar fx = blocks.fx[b];
+	Scalar fy = blocks.fy[b];
+	Scalar mz = blocks.mz[b];
+	for (int k = adjacencyStart[b]; k < adjacencyStart[b+1]; k++) {
+	  int slot = adjacency[k] >> 1;
+	  if (adjacency[k] & 1) {
+	    fx -= faceFx[slot];
+	    fy -= faceFy[slot];
+	    mz -= faceMzPlus[slot];
+	  } else {
+	    fx += faceFx[slot];
+	    fy += faceFy[slot];
+	    mz += faceMzMinus[slot];
+	  }
+	} // for k = ...
+	blocks.fx[b] = fx;
+	blocks.fy[b] = fy;
+	blocks.mz[b] = mz;
+      } // for b = ...
+    });
+
+    // (the faces not stepped at the next substep, being of a coarser level, asleep or inside a rigid cluster, must
+    // not add their forces again, so the buffers hold no state between substeps)
+    std::fill(faceFx.begin(), faceFx.end(), 0.0);
+    std::fill(faceFy.begin(), faceFy.end(), 0.0);
+    std::fill(faceMzMinus.begin(), faceMzMinus.end(), 0.0);
+    std::fill(faceMzPlus.begin(), faceMzPlus.end(), 0.0);
+  } // gatherCohesiveForces()
+
   CohesiveZone* instantiateCohesiveZoneModel(Material* firstMaterial, Material* secondMaterial) {
-    float defaultStiffness = 200.0e+4;
-    float defaultViscosity = 100.0e+3;
-    float defaultFailureStrain = 5.0e-2;
-    float defaultMaxStrain = 5.0e-1;
-    float defaultFailureStress = defaultStiffness*defaultFailureStrain;
-    float defaulFractureEnergy = 0.5*defaultFailureStress*defaultMaxStrain;
-    float defaultYieldStress = 0.1*defaultFailureStress;
-    float defaultPlasticFailureStrain = 1.0e+3;
+    Scalar defaultStiffness = 200.0e+4;
+    Scalar defaultViscosity = 100.0e+3;
+    Scalar defaultFailureStrain = 5.0e-2;
+    Scalar defaultMaxStrain = 5.0e-1;
+    Scalar defaultFailureStress = defaultStiffness*defaultFailureStrain;
+    Scalar defaulFractureEnergy = 0.5*defaultFailureStress*defaultMaxStrain;
+    Scalar defaultYieldStress = 0.1*defaultFailureStress;
+    Scalar defaultPlasticFailureStrain = 1.0e+3;
     if ((firstMaterial->name == "Brick") || (secondMaterial->name == "Brick")) {
       return new Plasticity(defaultYieldStress,0.1*defaultStiffness,defaultPlasticFailureStrain,defaultStiffness,defaultViscosity);
     } else {
@@ -171,7 +564,56 @@ public:
     */
   } // instantiateCohesiveZoneModel()
 
+  // face pass used for all cohesive zones: FUSED evaluates kinematics, traction and force scatter in a single
+  // loop per face, whereas CHUNKED streams cache-sized chunks of faces through the (SIMD) traction kernels.
+  // AUTO uses the chunked pass only for laws with SIMD traction kernels on the current CPU
+  enum class ForceKernel { AUTO, FUSED, CHUNKED };
+
+  // parallel force assembly: COLORED scatters the faces of one color at a time, whereas GATHER stores
+  // the forces of all faces in a face-indexed buffer from which each block sums its own forces.
+  // Both sum the forces of each block in the same fixed order, independent of the number of threads
+  enum class Assembly { COLORED, GATHER };
+
   std::map<std::pair<Material*,Material*>,CohesiveZone*> cohesiveZones;
+  ForceKernel kernel = ForceKernel::AUTO;
+  Assembly assembly = Assembly::COLORED;
+  ThreadPool pool; // shared with the per-block update passes
+  Scalar solverTolerance = 1.0e-5; // relative residual of the implicit solves
+  int maxSolverIterations = 500;
+
+private:
+
+  // a contiguous range of one color list of a CZ type, assembled by a single thread
+  struct Slice {
+    CohesiveZone* zone;
+    const int* faces;
+    int count;
+    Orientation dir;
+  }; // Slice
+
+  // faces per slice: large enough to amortize the scheduling, small enough to balance the load
+  static const int SLICE_SIZE = 512;
+  static const int BLOCK_SLICE_SIZE = 1024;
+
+  std::vector<Slice> slices;
+  std::vector<std::pair<int,int> > failedFaces;
+  std::vector<Scalar> blockStiffness; // (time step estimate)
+  std::vector<Scalar> blockViscosity;
+  std::vector<Scalar> blockTimeStep;  // critical step of each block (fixed or unrestrained blocks: max)
+  std::vector<int> levels;           // (multi-rate level assignment)
+  int minLevel = 0;                  // coarsest level stepped at the current substep
+
+  // implicit integration
+  BlockSparseMatrix tangent;
+  std::vector<Scalar> rhs;
+
+  // gather-based assembly
+  std::vector<Scalar> faceFx;
+  std::vector<Scalar> faceFy;
+  std::vector<Scalar> faceMzMinus;
+  std::vector<Scalar> faceMzPlus;
+  std::vector<int> adjacencyStart; // CSR row pointers (one row per block)
+  std::vector<int> adjacency;      // 2*slot+side of each face of each block
 }; // CohesiveZoneManager
 
 #endif // COHESIVE_ZONE_MANAGER_H
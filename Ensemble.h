@@ -0,0 +1,260 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include "CZM.h"
+#include "ScenarioBatch.h"
+#include "ThreadPool.h"
+#include <vector>
+#include <string>
+#include <map>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+// Ensemble of runs of one layout under many ground motions (pairs of records and amplitude scale factors), as
+// needed for fragility studies. The layout (a Grid, whose cells refer to the materials of an inventory), the
+// records (each read once) and an optional prepared initial state are shared by all runs and only read. Each run
+// copies the layout and builds its own blocks, face lists, block-to-face adjacency and ground motion from it: as
+// the face lists are compacted and sorted while stepping (and the layout cells are numbered with the block IDs),
+// they are per-run state, and building them takes about as long as a few substeps of the run. The runs are
+// distributed dynamically over a thread pool, each thread taking the next run as soon as its last one is done (so
+// that runs that fail early and runs that shake to the end balance out), and each run steps on its own thread.
+// With lanes > 1, each thread instead steps several runs at once in the lanes of a ScenarioBatch, refilling a lane
+// as soon as its run ends.
+class Ensemble {
+public:
+
+  struct Run {
+    std::string ux;      // horizontal record (PEER)
+    std::string uy;      // vertical record (optional)
+    float scale = 10.0;  // amplitude scale factor
+  }; // Run
+
+  // summary of a run (the quantities reported by czm_batch)
+  struct Result {
+    bool completed = false; // false if a record could not be read, or the initial state did not fit the layout
+    long substeps = 0;
+    double time = 0.0;
+    float kineticEnergy = 0.0;
+    int failedFaces = 0;
+    int totalFaces = 0;
+    Blocks::FragmentStatistics fragments;
+    double wallSeconds = 0.0;
+  }; // Result
+
+  // run every (record, scale) pair on the given number of threads (0: all cores), from the start of the layout or
+  // from a state prepared by CZM::saveState (which then continues under each run's own record); returns the
+  // results in the order of the runs
+  std::vector<Result> run(const Grid& layout, const std::vector<Run>& runs, int threads = 0, const Checkpoint* initialState = nullptr) {
+    // (the records are read serially, as reading a record may write its cache)
+    std::map<std::string,Record> records;
+    for (const Run& run : runs) {
+      load(run.ux, records);
+      if (!run.uy.empty()) load(run.uy, records);
+    } // for run = ...
+
+    std::vector<Result> results(runs.size());
+    ThreadPool pool;
+    pool.resize(threads);
+    if (batched()) {
+      // (each thread steps a batch of runs, refilling its lanes from the shared list of runs)
+      std::atomic<int> next{0};
+      pool.parallelFor(pool.size(), [&](int thread, int i) {
+	simulateBatch(layout, runs, records, initialState, next, results);
+      });
+      return results;
+    }
+    pool.parallelFor(runs.size(), [&](int thread, int i) {
+      results[i] = simulate(layout, runs[i], records, initialState);
+    });
+    return results;
+  } // run()
+
+  // settings of every run (as the czm_batch options of the same names)
+  float timescale = 50.0;    // simulation time units per record second
+  Coordinate dt = 0.0;       // substep size (0: automatic)
+  float safety = 0.8;
+  int levels = 0;
+  float implicit = 0.0;      // implicit substeps of this many stable time steps (0: explicit)
+  int sleepSteps = 0;
+  float splitFraction = 0.0; // rigid clusters (0: off)
+  bool gather = false;
+  long maxSubsteps = 1000000;
+  long checkInterval = 500;
+  float keTolerance = 1.0e-3;
+  bool cache = true;         // keep binary copies of the records (see GroundMotion::readPEER)
+  int lanes = 1;             // runs stepped together by each thread in a ScenarioBatch (at most ScenarioBatch::LANES)
+
+  // the runs are stepped in batches if lanes > 1 and the settings are supported by ScenarioBatch (a fixed dt,
+  // and explicit single-rate stepping without sleep or clusters); the results are the same either way
+  bool batched(void) const {
+    return (lanes > 1) && (dt > 0.0) && (implicit == 0.0) && (levels == 0) && (sleepSteps == 0) && (splitFraction == 0.0);
+  } // batched()
+
+private:
+
+  struct Record {
+    bool ok = false;
+    std::vector<float> values;
+    float dt = 0.0;
+  }; // Record
+
+  void load(const std::string& filename, std::map<std::string,Record>& records) {
+    if (records.count(filename) > 0) return;
+    Record& record = records[filename];
+    record.ok = GroundMotion::readPEER(filename.c_str(), record.values, record.dt, cache);
+  } // load()
+
+  // start a run (on the calling thread) from the layout under its record, with the settings of the ensemble and
+  // from the initial state (if any); returns false if a record could not be read, or the state did not fit
+  bool start(CZM& czm, const Grid& layout, const Run& run, const std::map<std::string,Record>& records, const Checkpoint* initialState) {
+    const Record& ux = records.at(run.ux);
+    if (!ux.ok) return false;
+    czm.grid = layout;
+    czm.dispTimeHistory.ux = ux.values;
+    if (!run.uy.empty()) {
+      const Record& uy = records.at(run.uy);
+      if (!uy.ok || (uy.dt != ux.dt)) return false;
+      czm.dispTimeHistory.uy = uy.values;
+    }
+    czm.dispTimeHistory.dt = timescale*ux.dt;
+    czm.dispTimeHistory.scale = run.scale;
+
+    czm.simulation();
+    czm.safety = safety;
+    czm.maxLevel = levels;
+    czm.blocks.sleeping = (sleepSteps > 0);
+    czm.blocks.sleepSteps = sleepSteps;
+    czm.blocks.clustering = (splitFraction > 0.0);
+    czm.blocks.splitFraction = splitFraction;
+    if (implicit > 0.0) {
+      czm.integrator = CZM::Integrator::IMPLICIT;
+      czm.implicitScale = implicit;
+    }
+    if (gather) czm.faces.assembly = CohesiveZoneManager::Assembly::GATHER;
+    if (initialState != nullptr) {
+      if (!czm.loadState(*initialState)) return false;
+      // (the ground continues from this run's record at the saved time)
+      czm.dispTimeHistory.seek(czm.time);
+    }
+    if (dt != 0.0) czm.dispTimeHistory.resample(dt);
+    return true;
+  } // start()
+
+  // summary of a completed run
+  void summarize(CZM& czm, Result& result, std::chrono::steady_clock::time_point start) {
+    result.completed = true;
+    result.time = czm.time;
+    result.kineticEnergy = czm.blocks.kineticEnergy();
+    result.totalFaces = czm.faces.totalFaces();
+    result.failedFaces = result.totalFaces - czm.faces.activeFaces();
+    result.fragments = czm.blocks.fragmentStatistics();
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  } // summarize()
+
+  // a single run (on the calling thread), stepped as by czm_batch
+  Result simulate(const Grid& layout, const Run& run, const std::map<std::string,Record>& records, const Checkpoint* initialState) {
+    Result result;
+    auto begin = std::chrono::steady_clock::now();
+    CZM czm;
+    if (!start(czm, layout, run, records, initialState)) return result;
+    bool automaticDT = (dt == 0.0);
+
+    // integrate until the substep budget is exhausted, or the shaking has ended and the motion has decayed
+    Coordinate shakingDuration = czm.dispTimeHistory.duration();
+    Coordinate substepDT = dt;
+    Coordinate coarseDT = dt;
+    // (a run branched from a saved state keeps its estimated step until its next check)
+    long nextCheck = czm.substepsToCheck;
+    if (automaticDT && (nextCheck > 0)) {
+      if (implicit > 0.0) {
+	substepDT = czm.estimatedDT;
+      } else {
+	coarseDT = czm.estimatedDT;
+      }
+    }
+    while (result.substeps < maxSubsteps) {
+      if (automaticDT && (result.substeps >= nextCheck)) {
+	if (implicit > 0.0) {
+	  substepDT = implicit*czm.stableTimeStep();
+	} else {
+	  coarseDT = czm.coarseTimeStep();
+	}
+      }
+      if (result.substeps >= nextCheck) nextCheck = result.substeps + checkInterval;
+      if (automaticDT && (implicit == 0.0)) {
+	result.substeps += czm.coarseStep(coarseDT);
+      } else {
+	czm.timeIntegrate(substepDT);
+	result.substeps++;
+      }
+      if ((result.substeps >= nextCheck) && (czm.time > shakingDuration) && (czm.blocks.kineticEnergy() < keTolerance)) break;
+    } // while (result.substeps < maxSubsteps)
+
+    summarize(czm, result, begin);
+    return result;
+  } // simulate()
+
+  // runs stepped in the lanes of a ScenarioBatch (on the calling thread): each lane takes the next run of the
+  // ensemble (through next) as soon as its last one has ended, and each run is stepped and stopped exactly as
+  // by simulate(). Runs that do not fit the batch are simulated on their own
+  void simulateBatch(const Grid& layout, const std::vector<Run>& runs, const std::map<std::string,Record>& records, const Checkpoint* initialState,
+		     std::atomic<int>& next, std::vector<Result>& results) {
+    ScenarioBatch batch;
+    bool tried = false;
+    bool initialized = false;
+    int Nlanes = std::min(lanes, ScenarioBatch::LANES);
+    std::unique_ptr<CZM> czm[ScenarioBatch::LANES];
+    int index[ScenarioBatch::LANES];
+    long nextCheck[ScenarioBatch::LANES];
+    Coordinate shakingDuration[ScenarioBatch::LANES];
+    std::chrono::steady_clock::time_point begin[ScenarioBatch::LANES];
+
+    // load the next run into lane k (false once the ensemble is exhausted)
+    auto fill = [&](int k) {
+      for (int i = next++; i < int(runs.size()); i = next++) {
+	begin[k] = std::chrono::steady_clock::now();
+	czm[k].reset(new CZM());
+	if (!start(*czm[k], layout, runs[i], records, initialState)) continue;
+	if (!tried) {
+	  tried = true;
+	  initialized = batch.initialize(*czm[k]);
+	}
+	if (!initialized || !batch.load(k, czm[k].get())) {
+	  results[i] = simulate(layout, runs[i], records, initialState);
+	  continue;
+	}
+	index[k] = i;
+	nextCheck[k] = czm[k]->substepsToCheck;
+	shakingDuration[k] = czm[k]->dispTimeHistory.duration();
+	return true;
+      } // for i = ...
+      batch.load(k, nullptr);
+      czm[k].reset();
+      index[k] = -1;
+      return false;
+    };
+
+    int active = 0;
+    for (int k = 0; k < Nlanes; k++) active += fill(k);
+    while (active > 0) {
+      for (int k = 0; k < Nlanes; k++) {
+	if ((index[k] >= 0) && (results[index[k]].substeps >= nextCheck[k])) nextCheck[k] = results[index[k]].substeps + checkInterval;
+      } // for k = ...
+      batch.timeIntegrate(dt);
+      for (int k = 0; k < Nlanes; k++) {
+	if (index[k] < 0) continue;
+	Result& result = results[index[k]];
+	result.substeps++;
+	if ((result.substeps < maxSubsteps) &&
+	    !((result.substeps >= nextCheck[k]) && (czm[k]->time > shakingDuration[k]) && (batch.kineticEnergy(k) < keTolerance))) continue;
+	batch.store(k);
+	summarize(*czm[k], result, begin[k]);
+	if (!fill(k)) active--;
+      } // for k = ...
+    } // while (active > 0)
+  } // simulateBatch()
+}; // Ensemble
+
+#endif // ENSEMBLE_H
@@ -1,20 +1,29 @@
 #ifndef GRID_H
 #define GRID_H
 
+#ifndef CZM_HEADLESS
 #if __APPLE__
 #include <GLUT/glut.h>
 #else
 #include <GL/glut.h>
 #endif
+#endif // CZM_HEADLESS
 
 #include "Materials.h"
 #include <vector>
+#include <map>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
 #include <cmath>
 
+#ifndef CZM_HEADLESS
 // forward declarations
 void GridSwipeAdd(int x, int y);
 void GridSwipeRemove(int x, int y);
 void GridHighlight(int x, int y);
+#endif // CZM_HEADLESS
 
 class Grid {
 public:
@@ -55,6 +64,71 @@ public:
     std::fill(blockIDs.begin(), blockIDs.end(), -1);
   } // edit()
 
+  // Load a material layout from a plain text file. Lines beginning with '#' are comments,
+  // lines of the form "<symbol> = <material name>" define the legend, and all remaining
+  // lines are grid rows listed from top to bottom, using '.' for empty cells, e.g.:
+  //   # two-story tower on soil
+  //   C = Concrete
+  //   S = Soil
+  //   ..CCC..
+  //   SSSSSSS
+  bool load(const char* filename, MaterialInventory& inventory, float cellSize = 1.0) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+      std::cerr << "ERROR: Unable to open layout file " << filename << std::endl;
+      return false;
+    }
+
+    // parse the legend and the grid rows
+    std::map<char,Material*> legend;
+    std::vector<std::string> rows;
+    std::string line;
+    while (std::getline(file, line)) {
+      if (!line.empty() && (line.back() == '\r')) line.pop_back();
+      if (line.empty() || (line[0] == '#')) continue;
+      size_t equals = line.find('=');
+      if (equals != std::string::npos) {
+	std::string symbol, name;
+	std::istringstream(line.substr(0,equals)) >> symbol;
+	std::istringstream(line.substr(equals+1)) >> name;
+	Material* material = inventory.findMaterial(name);
+	if ((symbol.size() != 1) || (material == nullptr)) {
+	  std::cerr << "ERROR: Invalid layout legend entry: " << line << std::endl;
+	  return false;
+	}
+	legend[symbol[0]] = material;
+      } else {
+	if (!rows.empty() && (line.size() != rows[0].size())) {
+	  std::cerr << "ERROR: Layout rows must all have the same length" << std::endl;
+	  return false;
+	}
+	rows.push_back(line);
+      } // if (equals != std::string::npos)
+    } // while (std::getline(file, line))
+    if (rows.empty()) {
+      std::cerr << "ERROR: Layout file " << filename << " contains no grid rows" << std::endl;
+      return false;
+    }
+
+    // fill the grid cells (row j = 0 is the bottom of the domain)
+    int xcells = rows[0].size();
+    int ycells = rows.size();
+    initialize(xcells, ycells, cellSize*xcells, cellSize*ycells);
+    std::fill(cells.begin(), cells.end(), nullptr);
+    for (int j = 0; j < Ny; j++) {
+      const std::string& row = rows[Ny-1-j];
+      for (int i = 0; i < Nx; i++) {
+	if (row[i] == '.') continue;
+	if (legend.count(row[i]) == 0) {
+	  std::cerr << "ERROR: Undefined layout symbol '" << row[i] << "'" << std::endl;
+	  return false;
+	}
+	cells[Nx*j+i] = legend[row[i]];
+      } // for i = ...
+    } // for j = ...
+    return true;
+  } // load()
+
   void swipeAdd(int x, int y) {
     int i = std::min(std::max(int(floor(x / dx)),0),Nx-1);
     int j = std::min(std::max(Ny-1-int(floor(y / dx)),0),Ny-1);
@@ -84,6 +158,7 @@ public:
     current_ij[1] = std::min(std::max(Ny-1-int(floor(y / dx)),0),Ny-1);
   } // update_cursor()
 
+#ifndef CZM_HEADLESS
   void modify(int button, int state, int x, int y) {
     int i = std::min(std::max(int(floor(x / dx)),0),Nx-1);
     int j = std::min(std::max(Ny-1-int(floor(y / dx)),0),Ny-1);
@@ -106,6 +181,7 @@ public:
       glutMotionFunc(GridSwipeRemove);
     }
   } // modify()
+#endif // CZM_HEADLESS
 
   void selectBrushColor(int button, int dir, int x, int y) {
     if (dir > 0) {
@@ -117,6 +193,7 @@ public:
     }
   } // selectBrush()
 
+#ifndef CZM_HEADLESS
   void render(void) {
 
     // load material textures
@@ -181,6 +258,7 @@ public:
     glEnd();
 
   } // render()
+#endif // CZM_HEADLESS
 
   int Nx;
   int Ny;
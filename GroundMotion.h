@@ -1,29 +1,588 @@
 #ifndef GROUND_MOTION_H
 #define GROUND_MOTION_H
 
+#include "Precision.h"
+#include "Checkpoint.h"
+#include "Simd.h"
+#include "ThreadPool.h"
 #include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <thread>
+#include <charconv>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
 #include <cmath>
 
 class GroundMotion {
 public:
 
-  void evaluate(float time, float& uxt, float& uyt) {
-    float frac = time / dt;
-    int n = floor(frac);
-    if ((n+1) < ux.size()) {
-      frac -= n;
-      uxt = scale*(frac*ux[n+1] + (1.0-frac)*ux[n]);
-      uyt = 0.0*(frac*uy[n+1] + (1.0-frac)*uy[n]);
+  // (evaluated at the precision of the block positions, as the boundary blocks are moved by its increments)
+  void evaluate(Coordinate time, Coordinate& uxt, Coordinate& uyt) const {
+    Coordinate frac = (dt > 0.0) ? time / dt : 0.0;
+    interpolate(floor(frac), frac, uxt, uyt);
+  } // evaluate
+
+  // restart the incremental evaluation (advance) at a time
+  void seek(Coordinate time) {
+    cursorTime = time;
+    cursor = (dt > 0.0) ? std::max(0L, long(floor(time / dt))) : 0;
+    step = 0;
+    evaluate(time, currentX, currentY);
+  } // seek()
+
+  // advance the ground from the time of the last call (or seek) to the given time, the end of a substep of length
+  // substepDT: returns the displacement increments and the ground velocity over the substep. The displacement at
+  // the start of the substep is kept from the last call, and the record interval is found by moving a cursor
+  // forward; with a resampled record (see resample), a run of substeps of the resampled length from time 0 only
+  // reads the precomputed increments
+  void advance(Coordinate time, Coordinate substepDT, Coordinate& dux, Coordinate& duy, Scalar& vx, Scalar& vy) {
+    if (resampleDT > 0.0) {
+      if ((substepDT == resampleDT) && (step < int(resampledVX.size()))) {
+	dux = resampledUX[step];
+	duy = resampledUY[step];
+	vx = resampledVX[step];
+	vy = resampledVY[step];
+	step++;
+	currentX += dux;
+	currentY += duy;
+	cursorTime = time;
+	return;
+      }
+      // (the substeps no longer follow the resampled grid)
+      if (substepDT != resampleDT) {
+	clearResampling();
+	seek(cursorTime);
+      }
+    }
+    Coordinate frac = (dt > 0.0) ? time / dt : 0.0;
+    if ((frac < cursor) || ((frac - cursor) > 16.0)) {
+      cursor = floor(frac);
     } else {
-      uxt = 0.0;
-      uyt = 0.0;
+      while ((cursor + 1) <= frac) cursor++;
     }
-  } // evaluate
+    Coordinate uxt;
+    Coordinate uyt;
+    interpolate(cursor, frac, uxt, uyt);
+    dux = uxt - currentX;
+    duy = uyt - currentY;
+    vx = Scalar(dux / substepDT);
+    vy = Scalar(duy / substepDT);
+    currentX = uxt;
+    currentY = uyt;
+    cursorTime = time;
+  } // advance()
+
+  // precompute the ground increments and velocities of substeps of length substepDT from time 0 (up to the end
+  // of the record), for runs with a fixed substep; the increments are those of evaluate at the substep times
+  // (rather than at the accumulated simulation time). Returns false (leaving the record to be evaluated
+  // incrementally) if the table would exceed MAX_RESAMPLED substeps
+  static const long MAX_RESAMPLED = 1 << 24;
+  bool resample(Coordinate substepDT) {
+    clearResampling();
+    if (substepDT <= 0.0) return false;
+    long Nsteps = long(ceil(duration() / substepDT)) + 1;
+    if (Nsteps > MAX_RESAMPLED) return false;
+    resampledUX.reserve(Nsteps);
+    resampledUY.reserve(Nsteps);
+    resampledVX.reserve(Nsteps);
+    resampledVY.reserve(Nsteps);
+    Coordinate uxOld;
+    Coordinate uyOld;
+    evaluate(0.0, uxOld, uyOld);
+    for (long k = 0; k < Nsteps; k++) {
+      Coordinate uxNew;
+      Coordinate uyNew;
+      evaluate(Coordinate(k+1)*substepDT, uxNew, uyNew);
+      resampledUX.push_back(uxNew - uxOld);
+      resampledUY.push_back(uyNew - uyOld);
+      resampledVX.push_back(Scalar((uxNew - uxOld) / substepDT));
+      resampledVY.push_back(Scalar((uyNew - uyOld) / substepDT));
+      uxOld = uxNew;
+      uyOld = uyNew;
+    } // for k = ...
+    resampleDT = substepDT;
+    return true;
+  } // resample()
+
+  void clearResampling(void) {
+    resampleDT = 0.0;
+    resampledUX.clear();
+    resampledUY.clear();
+    resampledVX.clear();
+    resampledVY.clear();
+  } // clearResampling()
+
+  // ground displacement at the time of the last call to advance (or seek)
+  Coordinate currentX = 0.0;
+  Coordinate currentY = 0.0;
+
+  // save or restore the state of the incremental evaluation (the record itself is not saved)
+  void checkpoint(Checkpoint& checkpoint) {
+    checkpoint.value(cursorTime);
+    checkpoint.value(cursor);
+    checkpoint.value(step);
+    checkpoint.value(currentX);
+    checkpoint.value(currentY);
+  } // checkpoint()
+
+  Coordinate duration(void) {
+    return (ux.size() > 1) ? Coordinate(dt)*(ux.size()-1) : 0.0;
+  } // duration()
+
+  // header of a PEER NGA time series file (*.AT2, *.VT2, *.DT2)
+  struct Record {
+    std::string filename;
+    std::string description; // earthquake, date, station and component (second header line)
+    std::string quantity;    // e.g. "DISPLACEMENT TIME SERIES IN UNITS OF CM" (third header line)
+    int npts = 0;
+    float dt = 0.0;
+  }; // Record
+
+  // Read the header of a PEER NGA time series: four lines, the last of which holds "NPTS= <n>, DT= <dt> SEC"
+  static bool readHeader(const char* filename, Record& record) {
+    FILE* file = fopen(filename, "r");
+    if (file == nullptr) return false;
+    char lines[4][256];
+    bool complete = true;
+    for (int i = 0; (i < 4) && complete; i++) complete = (fgets(lines[i], sizeof(lines[i]), file) != nullptr);
+    fclose(file);
+    return complete && parseHeader(lines[1], lines[2], lines[3], filename, record);
+  } // readHeader()
+
+  // Read a single PEER NGA time series. The file is memory-mapped and its values parsed in place; unless cache
+  // is false, the values are then stored in a binary sidecar file (filename + ".czmbin", tagged with the size and
+  // modification time of the record), from which later reads of the same record are a single copy
+  static bool readPEER(const char* filename, std::vector<float>& values, float& recordDT, bool cache = true) {
+    std::string sidecar = std::string(filename) + ".czmbin";
+    CacheHeader source;
+    bool stamped = stamp(filename, source);
+    if (cache && stamped && readCache(sidecar.c_str(), source, values, recordDT)) return true;
+
+    MappedFile file(filename);
+    if (file.data == nullptr) {
+      std::cerr << "ERROR: Unable to open ground motion file " << filename << std::endl;
+      return false;
+    }
+    const char* p = file.data;
+    const char* end = file.data + file.size;
+    const char* lines[5];
+    lines[0] = p;
+    for (int i = 1; i < 5; i++) {
+      while ((p < end) && (*p != '\n')) p++;
+      if (p < end) p++;
+      lines[i] = p;
+    } // for i = ...
+    Record record;
+    std::string description(lines[1], lines[2]);
+    std::string quantity(lines[2], lines[3]);
+    std::string counts(lines[3], lines[4]);
+    if (!parseHeader(description.c_str(), quantity.c_str(), counts.c_str(), filename, record)) {
+      std::cerr << "ERROR: Unable to parse PEER header of " << filename << std::endl;
+      return false;
+    }
+    recordDT = record.dt;
+
+    // (std::from_chars does not skip whitespace, nor accept a leading '+')
+    values.clear();
+    values.reserve(record.npts);
+    while (true) {
+      while ((p < end) && ((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n') || (*p == '+'))) p++;
+      if (p >= end) break;
+      float value;
+      std::from_chars_result result = std::from_chars(p, end, value);
+      if (result.ec != std::errc()) break;
+      values.push_back(value);
+      p = result.ptr;
+    } // while (true)
+    if (int(values.size()) != record.npts) {
+      std::cerr << "WARNING: " << filename << " holds " << values.size() << " values, but its header declares NPTS= " << record.npts << std::endl;
+    }
+
+    if (cache && stamped) writeCache(sidecar, source, values, recordDT);
+    return true;
+  } // readPEER()
+
+  // List the PEER time series in a directory (e.g. a downloaded NGA record catalog) from their headers alone,
+  // sorted by file name
+  static std::vector<Record> catalog(const char* directory) {
+    std::vector<Record> records;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+      std::string extension = entry.path().extension().string();
+      for (char& c : extension) c = toupper(c);
+      if ((extension != ".AT2") && (extension != ".VT2") && (extension != ".DT2")) continue;
+      Record record;
+      if (readHeader(entry.path().string().c_str(), record)) records.push_back(record);
+    } // for entry = ...
+    if (error) std::cerr << "ERROR: Unable to list ground motion directory " << directory << std::endl;
+    std::sort(records.begin(), records.end(), [](const Record& a, const Record& b) { return (a.filename < b.filename); });
+    return records;
+  } // catalog()
+
+  // elastic response spectra of a record: the peak relative displacement SD of a linear oscillator of each period
+  // (in record seconds) and damping ratio under the ground acceleration, with the pseudo-velocity PSV = w SD and
+  // the pseudo-acceleration PSA = w^2 SD. The values are stored [damping][period]; SD is in cm, PSV in cm/s
+  // and PSA in g (the PEER conventions)
+  struct Spectra {
+    bool ok = false; // false if the record could not be read, or is not a time series of a known quantity
+    std::vector<float> periods;
+    std::vector<float> damping;
+    std::vector<float> SD;
+    std::vector<float> PSV;
+    std::vector<float> PSA;
+  }; // Spectra
+
+  static constexpr double STANDARD_GRAVITY = 980.665; // cm/s^2
+
+  // Response spectra of a ground acceleration history (cm/s^2, at steps of dt seconds) over the periods and
+  // damping ratios (in [0,1)) of spectra. Each oscillator is stepped by the exact recurrence for an acceleration
+  // varying linearly over each record step (Nigam and Jennings), whose coefficients are computed once per
+  // oscillator; the oscillators are stepped side by side, across the lanes of the widest vector unit
+  static void responseSpectra(const std::vector<float>& acceleration, float dt, Spectra& spectra) {
+    int Nperiods = spectra.periods.size();
+    int Noscillators = Nperiods*spectra.damping.size();
+    Oscillators oscillators(Noscillators);
+    for (int i = 0; i < Noscillators; i++) oscillators.set(i, spectra.periods[i%Nperiods], spectra.damping[i/Nperiods], dt);
+
+    std::vector<float> peak(Noscillators);
+    int done = 0;
+#ifdef CZM_SIMD_X86
+    if      (simdLevel() == SimdLevel::AVX512) done = respondAVX512(oscillators, acceleration.data(), acceleration.size(), peak.data());
+    else if (simdLevel() == SimdLevel::AVX2)   done = respondAVX2(oscillators, acceleration.data(), acceleration.size(), peak.data());
+#endif
+    // step the remaining oscillators with the portable scalar kernel
+    respond(oscillators, done, acceleration.data(), acceleration.size(), peak.data());
+
+    spectra.SD.resize(Noscillators);
+    spectra.PSV.resize(Noscillators);
+    spectra.PSA.resize(Noscillators);
+    for (int i = 0; i < Noscillators; i++) {
+      double w = 2.0*M_PI/spectra.periods[i%Nperiods];
+      spectra.SD[i] = peak[i];
+      spectra.PSV[i] = w*peak[i];
+      spectra.PSA[i] = w*w*peak[i]/STANDARD_GRAVITY;
+    } // for i = ...
+    spectra.ok = true;
+  } // responseSpectra()
+
+  // Response spectra of PEER records (*.AT2, or the accelerations of *.VT2 and *.DT2 records, see
+  // groundAcceleration) over the same periods and damping ratios, read and computed concurrently on the given
+  // number of threads (0: all cores); returns the spectra in the order of the records
+  static std::vector<Spectra> responseSpectra(const std::vector<std::string>& filenames, const std::vector<float>& periods, const std::vector<float>& damping,
+					      int threads = 0, bool cache = true) {
+    std::vector<Spectra> spectra(filenames.size());
+    ThreadPool pool;
+    pool.resize(threads);
+    // (each record writes its own cache, if any, through a temporary file of the thread that read it)
+    pool.parallelFor(filenames.size(), [&](int thread, int i) {
+      spectra[i].periods = periods;
+      spectra[i].damping = damping;
+      Record record;
+      std::vector<float> values;
+      std::vector<float> acceleration;
+      float recordDT;
+      if (!readHeader(filenames[i].c_str(), record) || !readPEER(filenames[i].c_str(), values, recordDT, cache)) return;
+      if (!groundAcceleration(record.quantity, values, recordDT, acceleration)) return;
+      responseSpectra(acceleration, recordDT, spectra[i]);
+    });
+    return spectra;
+  } // responseSpectra()
+
+  // Ground acceleration history (cm/s^2) of a PEER record of the given quantity (the third header line): an
+  // acceleration in g or cm/s^2 is converted, and a velocity (cm/s) or displacement (cm) is differentiated by
+  // central differences. Returns false for other quantities
+  static bool groundAcceleration(const std::string& quantity, const std::vector<float>& values, float recordDT, std::vector<float>& acceleration) {
+    int N = values.size();
+    acceleration.assign(N, 0.0f);
+    if (quantity.find("ACCELERATION") != std::string::npos) {
+      bool g = (quantity.size() >= 2) && (quantity.compare(quantity.size()-2, 2, " G") == 0);
+      for (int n = 0; n < N; n++) acceleration[n] = g ? float(STANDARD_GRAVITY*values[n]) : values[n];
+    } else if (quantity.find("VELOCITY") != std::string::npos) {
+      for (int n = 1; (n+1) < N; n++) acceleration[n] = (values[n+1] - values[n-1]) / (2.0*recordDT);
+    } else if (quantity.find("DISPLACEMENT") != std::string::npos) {
+      for (int n = 1; (n+1) < N; n++) acceleration[n] = (values[n+1] - 2.0*values[n] + values[n-1]) / (double(recordDT)*recordDT);
+    } else {
+      std::cerr << "ERROR: Unknown ground motion quantity \"" << quantity << "\"" << std::endl;
+      return false;
+    }
+    return true;
+  } // groundAcceleration()
 
   std::vector<float> ux;
-  std::vector<float> uy;
-  float dt;
-  float scale;
+  std::vector<float> uy; // (vertical, may be shorter than ux)
+  float dt = 0.0;      // record time step (in simulation time units)
+  float scale = 1.0;   // amplitude scale factor
+
+private:
+
+  // displacements at record position frac, within the record interval n (frac - n in [0,1]); zero outside a
+  // component
+  void interpolate(long n, Coordinate frac, Coordinate& uxt, Coordinate& uyt) const {
+    frac -= n;
+    uxt = ((n >= 0) && ((n+1) < long(ux.size()))) ? Coordinate(scale*(frac*ux[n+1] + (1.0-frac)*ux[n])) : Coordinate(0.0);
+    uyt = ((n >= 0) && ((n+1) < long(uy.size()))) ? Coordinate(scale*(frac*uy[n+1] + (1.0-frac)*uy[n])) : Coordinate(0.0);
+  } // interpolate()
+
+  Coordinate cursorTime = 0.0;
+  long cursor = 0; // record interval of cursorTime
+  int step = 0;    // resampled substep of cursorTime
+  Coordinate resampleDT = 0.0;
+  std::vector<Coordinate> resampledUX;
+  std::vector<Coordinate> resampledUY;
+  std::vector<Scalar> resampledVX;
+  std::vector<Scalar> resampledVY;
+
+  // coefficients of the exact recurrence of each oscillator (unit mass, under the ground acceleration a) over a
+  // record step, in which the acceleration varies linearly from a0 to a1:
+  //   u' = uu u + uv v + u0 a0 + u1 a1
+  //   v' = vu u + vv v + v0 a0 + v1 a1
+  // (computed in double precision, then stepped in single precision)
+  struct Oscillators {
+    Oscillators(int size) : uu(size), uv(size), u0(size), u1(size), vu(size), vv(size), v0(size), v1(size) { }
+
+    void set(int i, double period, double damping, double dt) {
+      double w = 2.0*M_PI/period;
+      double wd = w*sqrt(1.0 - damping*damping);
+      double k = w*w;
+      double e = exp(-damping*w*dt);
+      double s = sin(wd*dt);
+      double c = cos(wd*dt);
+      double r = damping/sqrt(1.0 - damping*damping);
+      double zwdt = 2.0*damping/(w*dt);
+      // (the oscillator is loaded by -a)
+      uu[i] = e*(r*s + c);
+      uv[i] = e*s/wd;
+      u0[i] = -(zwdt + e*(((1.0 - 2.0*damping*damping)/(wd*dt) - r)*s - (1.0 + zwdt)*c))/k;
+      u1[i] = -(1.0 - zwdt + e*((2.0*damping*damping - 1.0)/(wd*dt)*s + zwdt*c))/k;
+      vu[i] = -e*w/sqrt(1.0 - damping*damping)*s;
+      vv[i] = e*(c - r*s);
+      v0[i] = -(-1.0/dt + e*((w/sqrt(1.0 - damping*damping) + r/dt)*s + c/dt))/k;
+      v1[i] = -(1.0 - e*(r*s + c))/(k*dt);
+    } // set()
+
+    int size(void) const {
+      return uu.size();
+    } // size()
+
+    std::vector<float> uu, uv, u0, u1;
+    std::vector<float> vu, vv, v0, v1;
+  }; // Oscillators
+
+  // step the oscillators from begin on over the acceleration history (from rest), and store their peak
+  // displacements
+  static void respond(const Oscillators& o, int begin, const float* a, int N, float* peak) {
+    for (int i = begin; i < o.size(); i++) {
+      float u = 0.0f;
+      float v = 0.0f;
+      float umax = 0.0f;
+      for (int n = 0; (n+1) < N; n++) {
+	float un = o.uu[i]*u + o.uv[i]*v + o.u0[i]*a[n] + o.u1[i]*a[n+1];
+	float vn = o.vu[i]*u + o.vv[i]*v + o.v0[i]*a[n] + o.v1[i]*a[n+1];
+	u = un;
+	v = vn;
+	umax = std::max(umax,std::fabs(u));
+      } // for n = ...
+      peak[i] = umax;
+    } // for i = ...
+  } // respond()
+
+#ifdef CZM_SIMD_X86
+  // variants of respond stepping 8 (AVX2) or 16 (AVX-512) oscillators per vector, and G vectors at once (so that
+  // the latency of each step overlaps); both return the number of oscillators processed (a multiple of the
+  // vector width), and reproduce respond bit for bit
+  __attribute__((target("avx2")))
+  static int respondAVX2(const Oscillators& o, const float* a, int N, float* peak) {
+    int i = 0;
+    for (; (i+32) <= o.size(); i += 32) respondAVX2<4>(o, i, a, N, peak);
+    for (; (i+8) <= o.size(); i += 8) respondAVX2<1>(o, i, a, N, peak);
+    return i;
+  } // respondAVX2()
+
+  template <int G>
+  __attribute__((target("avx2")))
+  static void respondAVX2(const Oscillators& o, int i, const float* a, int N, float* peak) {
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 uu[G], uv[G], u0[G], u1[G], vu[G], vv[G], v0[G], v1[G], u[G], v[G], umax[G];
+    for (int g = 0; g < G; g++) {
+      uu[g] = _mm256_loadu_ps(o.uu.data()+i+8*g);
+      uv[g] = _mm256_loadu_ps(o.uv.data()+i+8*g);
+      u0[g] = _mm256_loadu_ps(o.u0.data()+i+8*g);
+      u1[g] = _mm256_loadu_ps(o.u1.data()+i+8*g);
+      vu[g] = _mm256_loadu_ps(o.vu.data()+i+8*g);
+      vv[g] = _mm256_loadu_ps(o.vv.data()+i+8*g);
+      v0[g] = _mm256_loadu_ps(o.v0.data()+i+8*g);
+      v1[g] = _mm256_loadu_ps(o.v1.data()+i+8*g);
+      u[g] = _mm256_setzero_ps();
+      v[g] = _mm256_setzero_ps();
+      umax[g] = _mm256_setzero_ps();
+    } // for g = ...
+    for (int n = 0; (n+1) < N; n++) {
+      __m256 a0 = _mm256_set1_ps(a[n]);
+      __m256 a1 = _mm256_set1_ps(a[n+1]);
+      for (int g = 0; g < G; g++) {
+	__m256 un = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(uu[g],u[g]),_mm256_mul_ps(uv[g],v[g])),_mm256_mul_ps(u0[g],a0)),_mm256_mul_ps(u1[g],a1));
+	__m256 vn = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vu[g],u[g]),_mm256_mul_ps(vv[g],v[g])),_mm256_mul_ps(v0[g],a0)),_mm256_mul_ps(v1[g],a1));
+	u[g] = un;
+	v[g] = vn;
+	umax[g] = _mm256_max_ps(umax[g],_mm256_andnot_ps(sign,un));
+      } // for g = ...
+    } // for n = ...
+    for (int g = 0; g < G; g++) _mm256_storeu_ps(peak+i+8*g,umax[g]);
+  } // respondAVX2()
+
+  CZM_AVX512_BEGIN
+  __attribute__((target("avx512f")))
+  static int respondAVX512(const Oscillators& o, const float* a, int N, float* peak) {
+    int i = 0;
+    for (; (i+64) <= o.size(); i += 64) respondAVX512<4>(o, i, a, N, peak);
+    for (; (i+16) <= o.size(); i += 16) respondAVX512<1>(o, i, a, N, peak);
+    return i;
+  } // respondAVX512()
+
+  template <int G>
+  __attribute__((target("avx512f")))
+  static void respondAVX512(const Oscillators& o, int i, const float* a, int N, float* peak) {
+    const __m512i sign = _mm512_set1_epi32(0x80000000); // (AVX-512F has no floating point and-not)
+    __m512 uu[G], uv[G], u0[G], u1[G], vu[G], vv[G], v0[G], v1[G], u[G], v[G], umax[G];
+    for (int g = 0; g < G; g++) {
+      uu[g] = _mm512_loadu_ps(o.uu.data()+i+16*g);
+      uv[g] = _mm512_loadu_ps(o.uv.data()+i+16*g);
+      u0[g] = _mm512_loadu_ps(o.u0.data()+i+16*g);
+      u1[g] = _mm512_loadu_ps(o.u1.data()+i+16*g);
+      vu[g] = _mm512_loadu_ps(o.vu.data()+i+16*g);
+      vv[g] = _mm512_loadu_ps(o.vv.data()+i+16*g);
+      v0[g] = _mm512_loadu_ps(o.v0.data()+i+16*g);
+      v1[g] = _mm512_loadu_ps(o.v1.data()+i+16*g);
+      u[g] = _mm512_setzero_ps();
+      v[g] = _mm512_setzero_ps();
+      umax[g] = _mm512_setzero_ps();
+    } // for g = ...
+    for (int n = 0; (n+1) < N; n++) {
+      __m512 a0 = _mm512_set1_ps(a[n]);
+      __m512 a1 = _mm512_set1_ps(a[n+1]);
+      for (int g = 0; g < G; g++) {
+	__m512 un = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(uu[g],u[g]),_mm512_mul_ps(uv[g],v[g])),_mm512_mul_ps(u0[g],a0)),_mm512_mul_ps(u1[g],a1));
+	__m512 vn = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(vu[g],u[g]),_mm512_mul_ps(vv[g],v[g])),_mm512_mul_ps(v0[g],a0)),_mm512_mul_ps(v1[g],a1));
+	u[g] = un;
+	v[g] = vn;
+	umax[g] = _mm512_max_ps(umax[g],_mm512_castsi512_ps(_mm512_andnot_si512(sign,_mm512_castps_si512(un))));
+      } // for g = ...
+    } // for n = ...
+    for (int g = 0; g < G; g++) _mm512_storeu_ps(peak+i+16*g,umax[g]);
+  } // respondAVX512()
+  CZM_AVX512_END
+#endif // CZM_SIMD_X86
+
+  static bool parseHeader(const char* description, const char* quantity, const char* counts, const char* filename, Record& record) {
+    if (sscanf(counts, " NPTS= %d, DT= %f", &record.npts, &record.dt) != 2) return false;
+    record.filename = filename;
+    record.description = trim(description);
+    record.quantity = trim(quantity);
+    return true;
+  } // parseHeader()
+
+  static std::string trim(const char* text) {
+    std::string line(text);
+    size_t first = line.find_first_not_of(" \t\r\n");
+    size_t last = line.find_last_not_of(" \t\r\n");
+    return (first == std::string::npos) ? std::string() : line.substr(first, last-first+1);
+  } // trim()
+
+  // header of a binary sidecar file, followed by npts floats
+  struct CacheHeader {
+    char magic[8];         // "CZMPEER1"
+    uint64_t sourceSize;   // size and modification time of the record the values were read from
+    int64_t sourceTime;
+    uint32_t npts;
+    float dt;
+  }; // CacheHeader
+
+  static bool stamp(const char* filename, CacheHeader& header) {
+    std::error_code error;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "CZMPEER1", 8);
+    header.sourceSize = std::filesystem::file_size(filename, error);
+    if (error) return false;
+    header.sourceTime = std::filesystem::last_write_time(filename, error).time_since_epoch().count();
+    return !error;
+  } // stamp()
+
+  static bool readCache(const char* sidecar, const CacheHeader& source, std::vector<float>& values, float& recordDT) {
+    MappedFile file(sidecar);
+    if ((file.data == nullptr) || (file.size < sizeof(CacheHeader))) return false;
+    CacheHeader header;
+    memcpy(&header, file.data, sizeof(header));
+    if ((memcmp(header.magic, source.magic, 8) != 0) || (header.sourceSize != source.sourceSize) || (header.sourceTime != source.sourceTime) ||
+	(file.size != sizeof(CacheHeader) + header.npts*sizeof(float))) return false;
+    values.resize(header.npts);
+    if (header.npts > 0) memcpy(values.data(), file.data + sizeof(CacheHeader), header.npts*sizeof(float));
+    recordDT = header.dt;
+    return true;
+  } // readCache()
+
+  // (written to a temporary file and renamed, so that concurrent runs never see a partial cache; a read-only
+  // record directory simply leaves the record uncached)
+  static void writeCache(const std::string& sidecar, CacheHeader header, const std::vector<float>& values, float recordDT) {
+    header.npts = values.size();
+    header.dt = recordDT;
+    std::string temporary = sidecar + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (file == nullptr) return;
+    bool written = (fwrite(&header, sizeof(header), 1, file) == 1) && (fwrite(values.data(), sizeof(float), values.size(), file) == values.size());
+    written = (fclose(file) == 0) && written;
+    if (!written || (rename(temporary.c_str(), sidecar.c_str()) != 0)) remove(temporary.c_str());
+  } // writeCache()
+
+  // read-only view of a whole file (memory-mapped where available)
+  struct MappedFile {
+    MappedFile(const char* filename) {
+#ifdef CZM_MMAP
+      int descriptor = ::open(filename, O_RDONLY);
+      struct stat status;
+      if ((descriptor >= 0) && (fstat(descriptor, &status) == 0) && (status.st_size > 0)) {
+	void* mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	if (mapping != MAP_FAILED) {
+	  data = (const char*)mapping;
+	  size = status.st_size;
+	}
+      }
+      if (descriptor >= 0) ::close(descriptor);
+#else
+      FILE* file = fopen(filename, "rb");
+      if (file != nullptr) {
+	fseek(file, 0, SEEK_END);
+	buffer.resize(ftell(file));
+	fseek(file, 0, SEEK_SET);
+	if (!buffer.empty() && (fread(buffer.data(), 1, buffer.size(), file) == buffer.size())) {
+	  data = buffer.data();
+	  size = buffer.size();
+	}
+	fclose(file);
+      }
+#endif
+    } // MappedFile()
+
+    ~MappedFile() {
+#ifdef CZM_MMAP
+      if (data != nullptr) munmap((void*)data, size);
+#endif
+    } // ~MappedFile()
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data = nullptr;
+    size_t size = 0;
+#ifndef CZM_MMAP
+    std::vector<char> buffer;
+#endif
+  }; // MappedFile
 }; // GroundMotion
 
 #endif // GROUND_MOTION_H
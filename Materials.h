@@ -30,11 +30,9 @@ public:
   float        color[3]; // text color
   float        coord[4]; // texture coordinates
 
-  static unsigned int textures;
+  static inline unsigned int textures = 0; // (only used by the rendering thread)
 }; // Material
 
-unsigned int Material::textures = 0;
-
 class MaterialInventory {
 public:
 
@@ -46,6 +44,17 @@ public:
     return head;
   } // getFirstMaterial()
 
+  Material* findMaterial(const std::string& name) {
+    Material* material = head;
+    if (material != nullptr) {
+      do {
+	if (material->name == name) return material;
+	material = material->next;
+      } while (material != head);
+    } // if (material != nullptr)
+    return nullptr;
+  } // findMaterial()
+
   void insertMaterial(Material* newMaterial) {
     if (!head) {
       head = newMaterial;
@@ -60,6 +69,19 @@ public:
     }
   } // insertMaterial()
 
+  // populate the inventory with the default materials shared by all drivers (the single-cell "Player" material
+  // is only included if players is set)
+  void insertDefaultMaterials(bool players) {
+    insertMaterial(new Material("Rock",      3500.0,      16, 0.38, 0.38, 0.38, 0.0, 0.0, 0.2, 0.2));
+    insertMaterial(new Material("Soil",      1500.0,      64, 0.25, 0.50, 0.25, 0.2, 0.0, 0.4, 0.2));
+    insertMaterial(new Material("Concrete",  2400.0,      32, 0.75, 0.75, 0.75, 0.4, 0.0, 0.6, 0.2));
+    insertMaterial(new Material("Wood",       600.0,      32, 0.80, 0.45, 0.10, 0.6, 0.0, 0.8, 0.2));
+    insertMaterial(new Material("Steel",     8050.0,      16, 0.50, 0.63, 0.70, 0.8, 0.0, 1.0, 0.2));
+    insertMaterial(new Material("Brick",     2000.0,      32, 0.75, 0.10, 0.00, 0.0, 0.2, 0.2, 0.4));
+    //insertMaterial(new Material("Water",     1000.0,      32, 0.29, 0.22, 1.00, 0.4, 0.2, 0.6, 0.4));
+    if (players) insertMaterial(new Material("Player",    1000.0,       1, 1.00, 0.00, 0.50, 0.6, 0.2, 0.8, 0.4));
+  } // insertDefaultMaterials()
+
 protected:
   Material* head;
 }; // MaterialInventory
@@ -0,0 +1,33 @@
+#ifndef PRECISION_H
+#define PRECISION_H
+
+// floating-point types of the simulation state, selected at compile time:
+//   (default)    everything in single precision (fastest; the explicit SIMD kernels run at full width)
+//   CZM_MIXED    block positions and the simulation time in double precision, everything else (velocities,
+//                forces, face history and the traction kernels) in single precision; positions and time are
+//                accumulated over many small increments, so this keeps long runs over large domains accurate
+//                at nearly the cost of single precision
+//   CZM_DOUBLE   everything in double precision (the traction kernels then run the scalar code path)
+#if defined(CZM_DOUBLE)
+typedef double Scalar;
+typedef double Coordinate;
+#elif defined(CZM_MIXED)
+typedef float  Scalar;
+typedef double Coordinate;
+#else
+typedef float  Scalar;
+typedef float  Coordinate;
+#endif
+
+// name of the precision mode (for run summaries)
+inline const char* precisionName(void) {
+#if defined(CZM_DOUBLE)
+  return "double";
+#elif defined(CZM_MIXED)
+  return "mixed";
+#else
+  return "float";
+#endif
+} // precisionName()
+
+#endif // PRECISION_H
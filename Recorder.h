@@ -0,0 +1,154 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+// Time history recorder: a set of named probes (callables returning a value) is sampled every decimation
+// substeps, and each sample row (the time, then one value per probe) is pushed into a single-producer,
+// single-consumer lock-free ring buffer. A background thread drains the ring to a CSV or binary file, so that
+// the stepping thread never waits on I/O: if the ring is full, the sample is dropped (and counted) instead.
+//
+// The binary format is a header ("CZMREC1\n", then the number of columns as a uint32 and the column names, each
+// terminated by a newline), followed by the rows as doubles in native byte order
+class Recorder {
+public:
+
+  enum class Format { CSV, BINARY };
+
+  Recorder() = default;
+  Recorder(const Recorder&) = delete;
+  Recorder& operator=(const Recorder&) = delete;
+
+  ~Recorder() {
+    close();
+  } // ~Recorder()
+
+  // register a probe (before the recording is opened)
+  void addProbe(const std::string& name, std::function<double(void)> probe) {
+    names.push_back(name);
+    probes.push_back(probe);
+  } // addProbe()
+
+  void clearProbes(void) {
+    names.clear();
+    probes.clear();
+  } // clearProbes()
+
+  // start recording the registered probes to a file, with a ring of the given number of rows (rounded up to a
+  // power of two); returns false if the file cannot be opened
+  bool open(const std::string& filename, Format format = Format::CSV, int rows = 4096) {
+    close();
+    file = fopen(filename.c_str(), (format == Format::BINARY) ? "wb" : "w");
+    if (file == nullptr) {
+      std::cerr << "ERROR: Unable to open record file " << filename << std::endl;
+      return false;
+    }
+    this->format = format;
+    width = probes.size() + 1;
+    capacity = 1;
+    while (capacity < size_t(rows)) capacity *= 2;
+    ring.assign(capacity*width, 0.0);
+    head.store(0);
+    tail.store(0);
+    counter = 0;
+    dropped = 0;
+    writeHeader();
+    stopping.store(false);
+    writer = std::thread(&Recorder::drain, this);
+    return true;
+  } // open()
+
+  // record a sample at the given time, if this is a sampled substep (called once per substep)
+  inline void sample(double time) {
+    if ((file == nullptr) || (++counter < decimation)) return;
+    counter = 0;
+    size_t row = head.load(std::memory_order_relaxed);
+    if ((row - tail.load(std::memory_order_acquire)) >= capacity) {
+      dropped++;
+      return;
+    }
+    double* values = &ring[(row & (capacity-1))*width];
+    values[0] = time;
+    for (size_t i = 0; i < probes.size(); i++) values[i+1] = probes[i]();
+    head.store(row+1, std::memory_order_release);
+  } // sample()
+
+  // stop recording: write the remaining samples and close the file
+  void close(void) {
+    if (file == nullptr) return;
+    stopping.store(true);
+    writer.join();
+    fclose(file);
+    file = nullptr;
+    if (dropped > 0) std::cerr << "WARNING: " << dropped << " samples dropped (the recorder could not keep up)" << std::endl;
+  } // close()
+
+  bool recording(void) const {
+    return (file != nullptr);
+  } // recording()
+
+  int decimation = 1; // substeps per sample
+  long dropped = 0;   // samples dropped because the ring was full
+
+private:
+
+  void writeHeader(void) {
+    if (format == Format::BINARY) {
+      uint32_t columns = width;
+      fwrite("CZMREC1\n", 1, 8, file);
+      fwrite(&columns, sizeof(columns), 1, file);
+      fputs("time\n", file);
+      for (const std::string& name : names) fprintf(file, "%s\n", name.c_str());
+    } else {
+      fputs("time", file);
+      for (const std::string& name : names) fprintf(file, ",%s", name.c_str());
+      fputs("\n", file);
+    }
+  } // writeHeader()
+
+  // background thread: write the rows pushed since the last pass, until stopped (and drained)
+  void drain(void) {
+    while (true) {
+      bool stop = stopping.load(std::memory_order_acquire);
+      size_t first = tail.load(std::memory_order_relaxed);
+      size_t last = head.load(std::memory_order_acquire);
+      for (size_t row = first; row < last; row++) {
+	const double* values = &ring[(row & (capacity-1))*width];
+	if (format == Format::BINARY) {
+	  fwrite(values, sizeof(double), width, file);
+	} else {
+	  for (size_t i = 0; i < width; i++) fprintf(file, (i == 0) ? "%.9g" : ",%.9g", values[i]);
+	  fputs("\n", file);
+	}
+      } // for row = ...
+      tail.store(last, std::memory_order_release);
+      if (stop && (last == head.load(std::memory_order_acquire))) break;
+      if (last == first) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    } // while (true)
+    fflush(file);
+  } // drain()
+
+  std::vector<std::string> names;
+  std::vector<std::function<double(void)> > probes;
+  FILE* file = nullptr;
+  Format format = Format::CSV;
+  size_t width = 1;           // values per row
+  size_t capacity = 1;        // rows in the ring (a power of two)
+  std::vector<double> ring;
+  std::atomic<size_t> head{0}; // next row to be pushed (written by the stepping thread only)
+  std::atomic<size_t> tail{0}; // next row to be written out (written by the background thread only)
+  std::atomic<bool> stopping{false};
+  std::thread writer;
+  int counter = 0;
+}; // Recorder
+
+#endif // RECORDER_H
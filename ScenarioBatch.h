@@ -0,0 +1,768 @@
+#ifndef SCENARIO_BATCH_H
+#define SCENARIO_BATCH_H
+
+#include "CZM.h"
+#include "Simd.h"
+#include <vector>
+#include <map>
+#include <typeinfo>
+#include <iostream>
+#include <cmath>
+
+// the explicit SIMD kinematics load the block positions as floats, so mixed precision builds (double
+// positions) use the portable lane loops (the traction kernels of the laws remain vectorized)
+#if defined(CZM_SIMD_X86) && !defined(CZM_MIXED)
+#define CZM_BATCH_SIMD_X86 1
+#endif
+
+// Batched stepping of up to LANES runs (scenarios) of one layout that differ only in their ground motion. The
+// masses, boundary blocks, faces and face lists of the layout are shared, and every quantity of the simulation
+// state becomes a short vector holding its value in each scenario: the block state is stored [block][lane], and
+// each CZ type is replicated with face f of lane k as face f*LANES+k, so that its history is stored [face][lane].
+// The face pass then loads the blocks of each face once for all lanes, and evaluates the kinematics and the
+// tractions of all lanes at full SIMD width, without divergent index loads.
+//
+// Each lane reproduces the run it was loaded from (stepped by CZM::timeIntegrate with the same substep) bit for
+// bit: a face that has failed in some lanes is still evaluated in all of them, but masked out of the forces of
+// the lanes in which it has failed, and the contact of the fragments (which differ from lane to lane) is
+// evaluated per lane by the blocks of its run. Only explicit single-rate stepping without free bodies, sleep
+// or clusters is supported.
+class ScenarioBatch {
+public:
+
+  static const int LANES = 8;
+
+  ScenarioBatch() = default;
+  ScenarioBatch(const ScenarioBatch&) = delete;
+  ScenarioBatch& operator=(const ScenarioBatch&) = delete;
+
+  ~ScenarioBatch() {
+    for (Zone& zone : zones) delete zone.law;
+  } // ~ScenarioBatch()
+
+  // take the layout from a run started by CZM::simulation() (possibly restored to a saved state); every lane
+  // starts idle, holding the state of the prototype. Returns false if the run uses an unsupported option
+  bool initialize(CZM& prototype) {
+    for (Zone& zone : zones) delete zone.law;
+    zones.clear();
+    for (int k = 0; k < LANES; k++) run[k] = nullptr;
+    if (!supported(prototype)) return false;
+
+    // shared layout
+    Blocks& blocks = prototype.blocks;
+    Nblocks = blocks.Nblocks;
+    L = blocks.L;
+    mass = blocks.mass;
+    imass = blocks.imass;
+    iinertia = blocks.iinertia;
+    fixity = blocks.fixity;
+    boundary = blocks.boundary;
+    gravity = prototype.gravity;
+    drag_coefficient = prototype.drag_coefficient;
+
+    // replicate each CZ type once per lane (in the order of the colored assembly of the run)
+    for (auto cohesiveZone : prototype.faces.cohesiveZones) {
+      Zone zone;
+      zone.key = cohesiveZone.first;
+      zone.law = replicate(cohesiveZone.second);
+      if (zone.law == nullptr) {
+	std::cerr << "ERROR: ScenarioBatch does not support this cohesive zone model" << std::endl;
+	for (Zone& other : zones) delete other.law;
+	zones.clear();
+	return false;
+      }
+      zone.faceIDs[Orientation::X] = cohesiveZone.second->xFaceIDs;
+      zone.faceIDs[Orientation::Y] = cohesiveZone.second->yFaceIDs;
+      for (int color = 0; color < 2; color++) {
+	zone.faces[Orientation::X][color] = cohesiveZone.second->xColor[color];
+	zone.faces[Orientation::Y][color] = cohesiveZone.second->yColor[color];
+      } // for color = ...
+      for (auto face : zone.faceIDs[Orientation::X]) {
+	for (int k = 0; k < LANES; k++) zone.law->insertFaceX(face.first, face.second);
+      } // for face = ...
+      for (auto face : zone.faceIDs[Orientation::Y]) {
+	for (int k = 0; k < LANES; k++) zone.law->insertFaceY(face.first, face.second);
+      } // for face = ...
+      zone.law->initialize();
+      zones.push_back(zone);
+    } // for cohesiveZone = ...
+
+    // lane state
+    px.resize(LANES*Nblocks);
+    py.resize(LANES*Nblocks);
+    cz.resize(LANES*Nblocks);
+    sz.resize(LANES*Nblocks);
+    vx.resize(LANES*Nblocks);
+    vy.resize(LANES*Nblocks);
+    wz.resize(LANES*Nblocks);
+    fx.resize(LANES*Nblocks);
+    fy.resize(LANES*Nblocks);
+    mz.resize(LANES*Nblocks);
+    for (int k = 0; k < LANES; k++) {
+      if (!pack(k, prototype)) return false;
+    } // for k = ...
+    return true;
+  } // initialize()
+
+  // load the state of a run into a lane, which then steps that run (the run must have been started from the
+  // layout of the prototype, with the same face lists); nullptr leaves the lane idle. Returns false if the run
+  // does not fit the batch
+  bool load(int lane, CZM* czm) {
+    run[lane] = nullptr;
+    if (czm == nullptr) return true;
+    if (!supported(*czm) || !pack(lane, *czm)) return false;
+    run[lane] = czm;
+    return true;
+  } // load()
+
+  // write the state of a lane back into its run (which may then be summarized, checkpointed or stepped on its
+  // own, exactly as if it had been stepped by itself); the lane continues
+  void store(int lane) {
+    CZM& czm = *run[lane];
+    Blocks& blocks = czm.blocks;
+    for (int i = 0; i < Nblocks; i++) {
+      int n = LANES*i+lane;
+      blocks.px[i] = px[n];
+      blocks.py[i] = py[n];
+      blocks.cz[i] = cz[n];
+      blocks.sz[i] = sz[n];
+      blocks.vx[i] = vx[n];
+      blocks.vy[i] = vy[n];
+      blocks.wz[i] = wz[n];
+      blocks.fx[i] = fx[n];
+      blocks.fy[i] = fy[n];
+      blocks.mz[i] = mz[n];
+    } // for i = ...
+
+    // (the failed faces are dropped from the face lists of the run, whose blocks already hold the broken bonds)
+    for (Zone& zone : zones) {
+      exchangeHistory(zone.law, zone.single[lane], lane, false);
+      zone.single[lane]->compactFaces(failedFaces);
+    } // for zone = ...
+    failedFaces.clear();
+  } // store()
+
+  // advance every loaded lane by one substep dt (as CZM::timeIntegrate)
+  void timeIntegrate(Coordinate dt) {
+    // advance the ground motion of each lane over the substep, and move its boundary blocks with it
+    for (int k = 0; k < LANES; k++) {
+      if (run[k] == nullptr) continue;
+      CZM& czm = *run[k];
+      czm.time += dt;
+      Coordinate dux;
+      Coordinate duy;
+      Scalar groundVX;
+      Scalar groundVY;
+      czm.dispTimeHistory.advance(czm.time, dt, dux, duy, groundVX, groundVY);
+      czm.groundX = czm.dispTimeHistory.currentX;
+      czm.groundY = czm.dispTimeHistory.currentY;
+      Scalar ux = dux;
+      Scalar uy = duy;
+      for (int i : boundary) {
+	px[LANES*i+k] += ux;
+	py[LANES*i+k] += uy;
+	vx[LANES*i+k] = groundVX;
+	vy[LANES*i+k] = groundVY;
+      } // for i = ...
+    } // for k = ...
+
+    applyCohesiveForces();
+    applyContactForces();
+    integrate(dt);
+  } // timeIntegrate()
+
+  // kinetic energy of a lane (as Blocks::kineticEnergy)
+  Scalar kineticEnergy(int lane) {
+    Scalar energy = 0.0;
+    for (int i = 0; i < Nblocks; i++) {
+      int n = LANES*i+lane;
+      energy += mass[i]*(vx[n]*vx[n] + vy[n]*vy[n]) + (wz[n]*wz[n])/iinertia[i];
+    } // for i = ...
+    return 0.5*energy;
+  } // kineticEnergy()
+
+  CZM* run[LANES] = {}; // run stepped by each lane (nullptr: idle)
+
+private:
+
+  // a CZ type of the layout, replicated once per lane
+  struct Zone {
+    std::pair<Material*,Material*> key;
+    CohesiveZone* law = nullptr;                       // face f of lane k is face f*LANES+k
+    CohesiveZone* single[LANES] = {};                  // the CZ type of the run of each lane
+    std::vector<std::pair<int,int> > faceIDs[2];       // faces of the layout (x and y)
+    std::vector<int> faces[2][2];                      // active faces of each orientation and color
+    std::vector<int> dropped[2];                       // the face has failed in the lane (f*LANES+k)
+  }; // Zone
+
+  static bool supported(const CZM& czm) {
+    bool ok = czm.simulate && (czm.integrator == CZM::Integrator::EXPLICIT) && (czm.blocks.finestLevel == 0) &&
+      (czm.blocks.Nbodies == 0) && !czm.blocks.sleeping && !czm.blocks.clustering;
+    if (!ok) std::cerr << "ERROR: ScenarioBatch only supports explicit single-rate runs without free bodies, sleep or clusters" << std::endl;
+    return ok;
+  } // supported()
+
+  // a CZ type with the law and parameters of zone, but no faces
+  static CohesiveZone* replicate(CohesiveZone* zone) {
+    if (typeid(*zone) == typeid(Plasticity)) {
+      Plasticity* law = static_cast<Plasticity*>(zone);
+      return new Plasticity(law->yieldStress, law->Ehardening, law->failureStrain, law->stiffness, law->viscosity);
+    } else if (typeid(*zone) == typeid(CohesiveDamage)) {
+      CohesiveDamage* law = static_cast<CohesiveDamage*>(zone);
+      return new CohesiveDamage(law->failureStress, law->fractureEnergy, law->stiffness, law->viscosity);
+    } else if (typeid(*zone) == typeid(KelvinVoigt)) {
+      KelvinVoigt* law = static_cast<KelvinVoigt*>(zone);
+      return new KelvinVoigt(law->stiffness, law->viscosity);
+    }
+    return nullptr;
+  } // replicate()
+
+  // copy the state of a run into a lane
+  bool pack(int lane, CZM& czm) {
+    Blocks& blocks = czm.blocks;
+    bool fits = (blocks.Nblocks == Nblocks) && (czm.gravity == gravity) && (czm.drag_coefficient == drag_coefficient) &&
+      (czm.faces.cohesiveZones.size() == zones.size());
+    auto cohesiveZone = czm.faces.cohesiveZones.begin();
+    for (int z = 0; fits && (z < int(zones.size())); z++, cohesiveZone++) {
+      Zone& zone = zones[z];
+      CohesiveZone* single = cohesiveZone->second;
+      fits = (cohesiveZone->first == zone.key) && (typeid(*single) == typeid(*zone.law));
+      for (int color = 0; fits && (color < 2); color++) {
+	fits = (single->xColor[color] == zone.faces[Orientation::X][color]) && (single->yColor[color] == zone.faces[Orientation::Y][color]);
+      } // for color = ...
+    } // for z = ...
+    if (!fits) {
+      std::cerr << "ERROR: The run does not match the layout of the ScenarioBatch" << std::endl;
+      return false;
+    }
+
+    for (int i = 0; i < Nblocks; i++) {
+      int n = LANES*i+lane;
+      px[n] = blocks.px[i];
+      py[n] = blocks.py[i];
+      cz[n] = blocks.cz[i];
+      sz[n] = blocks.sz[i];
+      vx[n] = blocks.vx[i];
+      vy[n] = blocks.vy[i];
+      wz[n] = blocks.wz[i];
+      fx[n] = blocks.fx[i];
+      fy[n] = blocks.fy[i];
+      mz[n] = blocks.mz[i];
+    } // for i = ...
+    cohesiveZone = czm.faces.cohesiveZones.begin();
+    for (Zone& zone : zones) {
+      zone.single[lane] = (cohesiveZone++)->second;
+      exchangeHistory(zone.law, zone.single[lane], lane, true);
+      for (int dir = 0; dir < 2; dir++) {
+	zone.dropped[dir].resize(LANES*zone.faceIDs[dir].size());
+	for (int face = 0; face < int(zone.faceIDs[dir].size()); face++) zone.dropped[dir][LANES*face+lane] = 0;
+      } // for dir = ...
+    } // for zone = ...
+    return true;
+  } // pack()
+
+  // copy the history variables of a run's CZ type into a lane of its replica (toBatch), or back
+  static void exchangeHistory(CohesiveZone* replica, CohesiveZone* single, int lane, bool toBatch) {
+    if (typeid(*replica) == typeid(Plasticity)) {
+      Plasticity* batch = static_cast<Plasticity*>(replica);
+      Plasticity* law = static_cast<Plasticity*>(single);
+      exchange(batch->xEffectivePlasticSlip, law->xEffectivePlasticSlip, lane, toBatch);
+      exchange(batch->xPlasticSlip, law->xPlasticSlip, lane, toBatch);
+      exchange(batch->yEffectivePlasticSlip, law->yEffectivePlasticSlip, lane, toBatch);
+      exchange(batch->yPlasticSlip, law->yPlasticSlip, lane, toBatch);
+    } else if (typeid(*replica) == typeid(CohesiveDamage)) {
+      CohesiveDamage* batch = static_cast<CohesiveDamage*>(replica);
+      CohesiveDamage* law = static_cast<CohesiveDamage*>(single);
+      exchange(batch->xEdamaged, law->xEdamaged, lane, toBatch);
+      exchange(batch->xFailed, law->xFailed, lane, toBatch);
+      exchange(batch->yEdamaged, law->yEdamaged, lane, toBatch);
+      exchange(batch->yFailed, law->yFailed, lane, toBatch);
+    }
+  } // exchangeHistory()
+
+  // (quadrature point j of face f is entry 2*f+j of the run, and 2*(f*LANES+lane)+j of the replica)
+  template <class T>
+  static void exchange(std::vector<T>& batch, std::vector<T>& single, int lane, bool toBatch) {
+    int Nfaces = single.size()/2;
+    for (int f = 0; f < Nfaces; f++) {
+      for (int j = 0; j < 2; j++) {
+	if (toBatch) {
+	  batch[2*(f*LANES+lane)+j] = single[2*f+j];
+	} else {
+	  single[2*f+j] = batch[2*(f*LANES+lane)+j];
+	}
+      } // for j = ...
+    } // for f = ...
+  } // exchange()
+
+  // colored face pass over all lanes (in the order of CohesiveZoneManager::scatterCohesiveForces), followed by
+  // the failure of the faces that have failed in some lane during this pass
+  void applyCohesiveForces(void) {
+    // define local constants
+    Scalar dx = L;
+    Scalar divdx = 1.0/dx;
+    Scalar halfdx = 0.5*dx;
+    Scalar divsqrt3 = 1.0/sqrt(3.0);
+
+    for (int phase = 0; phase < 4; phase++) {
+      Orientation dir = (phase < 2) ? Orientation::X : Orientation::Y;
+      int color = phase % 2;
+      for (Zone& zone : zones) {
+	const std::vector<int>& faces = zone.faces[dir][color];
+	int count = faces.size();
+	for (int begin = 0; begin < count; begin += CHUNK_SIZE) {
+	  if (dir == Orientation::X) {
+	    applyChunk<Orientation::X>(zone, faces.data()+begin, std::min(CHUNK_SIZE, count-begin), dx, divdx, halfdx, divsqrt3);
+	  } else {
+	    applyChunk<Orientation::Y>(zone, faces.data()+begin, std::min(CHUNK_SIZE, count-begin), dx, divdx, halfdx, divsqrt3);
+	  }
+	} // for begin = ...
+      } // for zone = ...
+    } // for phase = ...
+
+    // drop the faces that have fully failed in a lane from the force pass of that lane, and hand the blocks
+    // they joined over to the contact of its run (in the order of CohesiveZone::compactFaces)
+    for (Zone& zone : zones) {
+      if (!zone.law->pendingFailure.load(std::memory_order_relaxed)) continue;
+      zone.law->pendingFailure.store(false, std::memory_order_relaxed);
+      for (int color = 0; color < 2; color++) {
+	for (int dir = 0; dir < 2; dir++) {
+	  for (int face : zone.faces[dir][color]) {
+	    for (int k = 0; k < LANES; k++) {
+	      if (zone.dropped[dir][LANES*face+k] || !zone.law->faceFailed(Orientation(dir), LANES*face+k)) continue;
+	      zone.dropped[dir][LANES*face+k] = 1;
+	      if (run[k] != nullptr) run[k]->blocks.breakBond(zone.faceIDs[dir][face].first, zone.faceIDs[dir][face].second);
+	    } // for k = ...
+	  } // for face = ...
+	} // for dir = ...
+      } // for color = ...
+    } // for zone = ...
+  } // applyCohesiveForces()
+
+  // kinematics, tractions and force scatter of a chunk of faces, in all lanes (as CohesiveZone::applyChunkedForces)
+  template <Orientation dir>
+  void applyChunk(Zone& zone, const int* faces, int count, Scalar dx, Scalar divdx, Scalar halfdx, Scalar divsqrt3) {
+    const std::pair<int,int>* faceIDs = zone.faceIDs[dir].data();
+    const int* dropped = zone.dropped[dir].data();
+    bool vectorized = false;
+#ifdef CZM_BATCH_SIMD_X86
+    vectorized = (simdLevel() != SimdLevel::SCALAR);
+#endif
+
+    // compute the kinematics of all faces in the current chunk (quadrature point j of face i in lane k is
+    // entry (2*i+j)*LANES+k of the workspace)
+    if (vectorized) {
+#ifdef CZM_BATCH_SIMD_X86
+      computeKinematicsAVX2<dir>(faceIDs, faces, count, halfdx, divsqrt3);
+#endif
+    } else {
+      for (int i = 0; i < count; i++) {
+	computeKinematics<dir>(faceIDs[faces[i]].first, faceIDs[faces[i]].second, halfdx, divsqrt3, 2*i);
+      } // for i = ...
+    }
+    for (int i = 0; i < count; i++) {
+      for (int j = 0; j < 2; j++) {
+	for (int k = 0; k < LANES; k++) work.ids[(2*i+j)*LANES+k] = 2*(faces[i]*LANES+k)+j;
+      } // for j = ...
+    } // for i = ...
+
+    // compute the cohesive traction vectors at each quadrature point of all lanes
+    zone.law->computeTraction(work.ux,work.uy,work.vx,work.vy,work.nx,work.ny,work.tx,work.ty,divdx,dir,2*LANES*count,work.ids);
+
+    // sum the cohesive tractions to the applied block forces of the lanes in which the face has not failed
+    if (vectorized) {
+#ifdef CZM_BATCH_SIMD_X86
+      scatterForcesAVX2(faceIDs, faces, count, dropped, dx, halfdx);
+#endif
+    } else {
+      for (int i = 0; i < count; i++) {
+	scatterForces(faceIDs[faces[i]].first, faceIDs[faces[i]].second, dropped+LANES*faces[i], 2*i, dx, halfdx);
+      } // for i = ...
+    }
+  } // applyChunk()
+
+  // compute the relative displacements, velocities, normals and moment arms at quadrature points j and j+1 of
+  // the face between blocks minus and plus in every lane (as CohesiveZone::computeKinematics)
+  template <Orientation dir>
+  inline void computeKinematics(int minus, int plus, Scalar halfdx, Scalar divsqrt3, int j) {
+    for (int k = 0; k < LANES; k++) {
+      int m = LANES*minus+k;
+      int p = LANES*plus+k;
+      int a = LANES*j+k;
+      int b = LANES*(j+1)+k;
+      if (dir == Orientation::X) {
+	Scalar sinl_halfdx = sz[m]*halfdx;
+	Scalar cosl_halfdx = cz[m]*halfdx;
+	Scalar sinr_halfdx = sz[p]*halfdx;
+	Scalar cosr_halfdx = cz[p]*halfdx;
+	Scalar cosavg = cz[m] + cz[p];
+	Scalar sinavg = sz[m] + sz[p];
+	Scalar inorm = 1.0f/sqrt(cosavg*cosavg + sinavg*sinavg);
+	work.nx[a] = cosavg*inorm;
+	work.ny[a] = sinavg*inorm;
+	work.nx[b] = work.nx[a];
+	work.ny[b] = work.ny[a];
+	Scalar ux0 = px[p] - px[m] - cosr_halfdx - cosl_halfdx;
+	Scalar uy0 = py[p] - py[m] - sinr_halfdx - sinl_halfdx;
+	Scalar diff_sin_halfdx = (sinr_halfdx - sinl_halfdx)*divsqrt3;
+	Scalar diff_cos_halfdx = (cosr_halfdx - cosl_halfdx)*divsqrt3;
+	work.ux[a] = ux0 + diff_sin_halfdx;
+	work.uy[a] = uy0 - diff_cos_halfdx;
+	work.ux[b] = ux0 - diff_sin_halfdx;
+	work.uy[b] = uy0 + diff_cos_halfdx;
+	Scalar dsinl_halfdx = +cosl_halfdx*wz[m];
+	Scalar dcosl_halfdx = -sinl_halfdx*wz[m];
+	Scalar dsinr_halfdx = +cosr_halfdx*wz[p];
+	Scalar dcosr_halfdx = -sinr_halfdx*wz[p];
+	Scalar vx0 = vx[p] - vx[m] - dcosr_halfdx - dcosl_halfdx;
+	Scalar vy0 = vy[p] - vy[m] - dsinr_halfdx - dsinl_halfdx;
+	Scalar diff_dsin_halfdx = (dsinr_halfdx - dsinl_halfdx)*divsqrt3;
+	Scalar diff_dcos_halfdx = (dcosr_halfdx - dcosl_halfdx)*divsqrt3;
+	work.vx[a] = vx0 + diff_dsin_halfdx;
+	work.vy[a] = vy0 - diff_dcos_halfdx;
+	work.vx[b] = vx0 - diff_dsin_halfdx;
+	work.vy[b] = vy0 + diff_dcos_halfdx;
+	work.rxm[a] = + cosl_halfdx + sinl_halfdx*divsqrt3 + 0.5*work.ux[a];
+	work.rym[a] = + sinl_halfdx - cosl_halfdx*divsqrt3 + 0.5*work.uy[a];
+	work.rxm[b] = + cosl_halfdx - sinl_halfdx*divsqrt3 + 0.5*work.ux[b];
+	work.rym[b] = + sinl_halfdx + cosl_halfdx*divsqrt3 + 0.5*work.uy[b];
+	work.rxp[a] = - cosr_halfdx + sinr_halfdx*divsqrt3 - 0.5*work.ux[a];
+	work.ryp[a] = - sinr_halfdx - cosr_halfdx*divsqrt3 - 0.5*work.uy[a];
+	work.rxp[b] = - cosr_halfdx - sinr_halfdx*divsqrt3 - 0.5*work.ux[b];
+	work.ryp[b] = - sinr_halfdx + cosr_halfdx*divsqrt3 - 0.5*work.uy[b];
+      } else { // if (dir == Orientation::Y)
+	Scalar sinl_halfdx = sz[m]*halfdx;
+	Scalar cosl_halfdx = cz[m]*halfdx;
+	Scalar sinu_halfdx = sz[p]*halfdx;
+	Scalar cosu_halfdx = cz[p]*halfdx;
+	Scalar cosavg = cz[m] + cz[p];
+	Scalar sinavg = sz[m] + sz[p];
+	Scalar inorm = 1.0f/sqrt(cosavg*cosavg + sinavg*sinavg);
+	work.nx[a] =-sinavg*inorm;
+	work.ny[a] = cosavg*inorm;
+	work.nx[b] = work.nx[a];
+	work.ny[b] = work.ny[a];
+	Scalar ux0 = px[p] - px[m] + sinu_halfdx + sinl_halfdx;
+	Scalar uy0 = py[p] - py[m] - cosu_halfdx - cosl_halfdx;
+	Scalar diff_sin_halfdx = (sinu_halfdx - sinl_halfdx)*divsqrt3;
+	Scalar diff_cos_halfdx = (cosu_halfdx - cosl_halfdx)*divsqrt3;
+	work.ux[a] = ux0 + diff_cos_halfdx;
+	work.uy[a] = uy0 + diff_sin_halfdx;
+	work.ux[b] = ux0 - diff_cos_halfdx;
+	work.uy[b] = uy0 - diff_sin_halfdx;
+	Scalar dsinl_halfdx = +cosl_halfdx*wz[m];
+	Scalar dcosl_halfdx = -sinl_halfdx*wz[m];
+	Scalar dsinu_halfdx = +cosu_halfdx*wz[p];
+	Scalar dcosu_halfdx = -sinu_halfdx*wz[p];
+	Scalar vx0 = vx[p] - vx[m] + dsinu_halfdx + dsinl_halfdx;
+	Scalar vy0 = vy[p] - vy[m] - dcosu_halfdx - dcosl_halfdx;
+	Scalar diff_dsin_halfdx = (dsinu_halfdx - dsinl_halfdx)*divsqrt3;
+	Scalar diff_dcos_halfdx = (dcosu_halfdx - dcosl_halfdx)*divsqrt3;
+	work.vx[a] = vx0 + diff_dcos_halfdx;
+	work.vy[a] = vy0 + diff_dsin_halfdx;
+	work.vx[b] = vx0 - diff_dcos_halfdx;
+	work.vy[b] = vy0 - diff_dsin_halfdx;
+	work.rxm[a] = - sinl_halfdx + cosl_halfdx*divsqrt3 + 0.5*work.ux[a];
+	work.rym[a] = + cosl_halfdx + sinl_halfdx*divsqrt3 + 0.5*work.uy[a];
+	work.rxm[b] = - sinl_halfdx - cosl_halfdx*divsqrt3 + 0.5*work.ux[b];
+	work.rym[b] = + cosl_halfdx - sinl_halfdx*divsqrt3 + 0.5*work.uy[b];
+	work.rxp[a] = + sinu_halfdx + cosu_halfdx*divsqrt3 - 0.5*work.ux[a];
+	work.ryp[a] = - cosu_halfdx + sinu_halfdx*divsqrt3 - 0.5*work.uy[a];
+	work.rxp[b] = + sinu_halfdx - cosu_halfdx*divsqrt3 - 0.5*work.ux[b];
+	work.ryp[b] = - cosu_halfdx - sinu_halfdx*divsqrt3 - 0.5*work.uy[b];
+      } // check X/Y-face orientation
+    } // for k = ...
+  } // computeKinematics()
+
+  // sum the cohesive tractions at quadrature points j and j+1 to the applied forces of blocks minus and plus, in
+  // the lanes in which the face has not failed (as CohesiveZone::scatterForces)
+  inline void scatterForces(int minus, int plus, const int* dropped, int j, Scalar dx, Scalar halfdx) {
+    const Scalar* tx = work.tx;
+    const Scalar* ty = work.ty;
+    for (int k = 0; k < LANES; k++) {
+      if (dropped[k]) continue;
+      int m = LANES*minus+k;
+      int p = LANES*plus+k;
+      int a = LANES*j+k;
+      int b = LANES*(j+1)+k;
+      Scalar fxk = (tx[a] + tx[b])*dx;
+      Scalar fyk = (ty[a] + ty[b])*dx;
+      fx[m] += fxk;
+      fy[m] += fyk;
+      fx[p] -= fxk;
+      fy[p] -= fyk;
+      mz[m] += (work.rxm[a]*ty[a] - work.rym[a]*tx[a] + work.rxm[b]*ty[b] - work.rym[b]*tx[b])*halfdx;
+      mz[p] -= (work.rxp[a]*ty[a] - work.ryp[a]*tx[a] + work.rxp[b]*ty[b] - work.ryp[b]*tx[b])*halfdx;
+    } // for k = ...
+  } // scatterForces()
+
+#ifdef CZM_BATCH_SIMD_X86
+  // AVX2 variants of computeKinematics and scatterForces over a chunk of faces, processing the 8 lanes of each
+  // quadrature point at once (same operations in the same order, so the results are identical)
+  template <Orientation dir>
+  __attribute__((target("avx2")))
+  void computeKinematicsAVX2(const std::pair<int,int>* faceIDs, const int* faces, int count, float halfdx_, float divsqrt3_) {
+    static_assert(LANES == 8, "the AVX2 kernels process 8 lanes");
+    const __m256 halfdx   = _mm256_set1_ps(halfdx_);
+    const __m256 divsqrt3 = _mm256_set1_ps(divsqrt3_);
+    const __m256 half     = _mm256_set1_ps(0.5f);
+    const __m256 one      = _mm256_set1_ps(1.0f);
+    const __m256 signbit  = _mm256_set1_ps(-0.0f);
+    for (int i = 0; i < count; i++) {
+      int m = LANES*faceIDs[faces[i]].first;
+      int p = LANES*faceIDs[faces[i]].second;
+      int a = LANES*(2*i);
+      int b = LANES*(2*i+1);
+
+      // load the sin and cos of the minus- and plus- block rotations
+      __m256 sinm = _mm256_loadu_ps(&sz[m]);
+      __m256 cosm = _mm256_loadu_ps(&cz[m]);
+      __m256 sinp = _mm256_loadu_ps(&sz[p]);
+      __m256 cosp = _mm256_loadu_ps(&cz[p]);
+      __m256 sinm_halfdx = _mm256_mul_ps(sinm,halfdx);
+      __m256 cosm_halfdx = _mm256_mul_ps(cosm,halfdx);
+      __m256 sinp_halfdx = _mm256_mul_ps(sinp,halfdx);
+      __m256 cosp_halfdx = _mm256_mul_ps(cosp,halfdx);
+
+      // compute the average face normal direction
+      __m256 cosavg = _mm256_add_ps(cosm,cosp);
+      __m256 sinavg = _mm256_add_ps(sinm,sinp);
+      __m256 inorm = _mm256_div_ps(one,_mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(cosavg,cosavg),_mm256_mul_ps(sinavg,sinavg))));
+      __m256 nx, ny;
+      if (dir == Orientation::X) {
+	nx = _mm256_mul_ps(cosavg,inorm);
+	ny = _mm256_mul_ps(sinavg,inorm);
+      } else {
+	nx = _mm256_mul_ps(_mm256_xor_ps(sinavg,signbit),inorm);
+	ny = _mm256_mul_ps(cosavg,inorm);
+      }
+      _mm256_storeu_ps(work.nx+a,nx);
+      _mm256_storeu_ps(work.ny+a,ny);
+      _mm256_storeu_ps(work.nx+b,nx);
+      _mm256_storeu_ps(work.ny+b,ny);
+
+      // compute the time-rates for sin and cos of the block rotations
+      __m256 wzm = _mm256_loadu_ps(&wz[m]);
+      __m256 wzp = _mm256_loadu_ps(&wz[p]);
+      __m256 dsinm_halfdx = _mm256_mul_ps(cosm_halfdx,wzm);
+      __m256 dcosm_halfdx = _mm256_mul_ps(_mm256_xor_ps(sinm_halfdx,signbit),wzm);
+      __m256 dsinp_halfdx = _mm256_mul_ps(cosp_halfdx,wzp);
+      __m256 dcosp_halfdx = _mm256_mul_ps(_mm256_xor_ps(sinp_halfdx,signbit),wzp);
+
+      // compute the quadrature point relative displacements and velocities
+      __m256 dpx = _mm256_sub_ps(_mm256_loadu_ps(&px[p]),_mm256_loadu_ps(&px[m]));
+      __m256 dpy = _mm256_sub_ps(_mm256_loadu_ps(&py[p]),_mm256_loadu_ps(&py[m]));
+      __m256 dvx = _mm256_sub_ps(_mm256_loadu_ps(&vx[p]),_mm256_loadu_ps(&vx[m]));
+      __m256 dvy = _mm256_sub_ps(_mm256_loadu_ps(&vy[p]),_mm256_loadu_ps(&vy[m]));
+      __m256 diff_sin_halfdx = _mm256_mul_ps(_mm256_sub_ps(sinp_halfdx,sinm_halfdx),divsqrt3);
+      __m256 diff_cos_halfdx = _mm256_mul_ps(_mm256_sub_ps(cosp_halfdx,cosm_halfdx),divsqrt3);
+      __m256 diff_dsin_halfdx = _mm256_mul_ps(_mm256_sub_ps(dsinp_halfdx,dsinm_halfdx),divsqrt3);
+      __m256 diff_dcos_halfdx = _mm256_mul_ps(_mm256_sub_ps(dcosp_halfdx,dcosm_halfdx),divsqrt3);
+      __m256 uxa, uya, uxb, uyb, vxa, vya, vxb, vyb;
+      if (dir == Orientation::X) {
+	__m256 ux0 = _mm256_sub_ps(_mm256_sub_ps(dpx,cosp_halfdx),cosm_halfdx);
+	__m256 uy0 = _mm256_sub_ps(_mm256_sub_ps(dpy,sinp_halfdx),sinm_halfdx);
+	uxa = _mm256_add_ps(ux0,diff_sin_halfdx);
+	uya = _mm256_sub_ps(uy0,diff_cos_halfdx);
+	uxb = _mm256_sub_ps(ux0,diff_sin_halfdx);
+	uyb = _mm256_add_ps(uy0,diff_cos_halfdx);
+	__m256 vx0 = _mm256_sub_ps(_mm256_sub_ps(dvx,dcosp_halfdx),dcosm_halfdx);
+	__m256 vy0 = _mm256_sub_ps(_mm256_sub_ps(dvy,dsinp_halfdx),dsinm_halfdx);
+	vxa = _mm256_add_ps(vx0,diff_dsin_halfdx);
+	vya = _mm256_sub_ps(vy0,diff_dcos_halfdx);
+	vxb = _mm256_sub_ps(vx0,diff_dsin_halfdx);
+	vyb = _mm256_add_ps(vy0,diff_dcos_halfdx);
+      } else {
+	__m256 ux0 = _mm256_add_ps(_mm256_add_ps(dpx,sinp_halfdx),sinm_halfdx);
+	__m256 uy0 = _mm256_sub_ps(_mm256_sub_ps(dpy,cosp_halfdx),cosm_halfdx);
+	uxa = _mm256_add_ps(ux0,diff_cos_halfdx);
+	uya = _mm256_add_ps(uy0,diff_sin_halfdx);
+	uxb = _mm256_sub_ps(ux0,diff_cos_halfdx);
+	uyb = _mm256_sub_ps(uy0,diff_sin_halfdx);
+	__m256 vx0 = _mm256_add_ps(_mm256_add_ps(dvx,dsinp_halfdx),dsinm_halfdx);
+	__m256 vy0 = _mm256_sub_ps(_mm256_sub_ps(dvy,dcosp_halfdx),dcosm_halfdx);
+	vxa = _mm256_add_ps(vx0,diff_dcos_halfdx);
+	vya = _mm256_add_ps(vy0,diff_dsin_halfdx);
+	vxb = _mm256_sub_ps(vx0,diff_dcos_halfdx);
+	vyb = _mm256_sub_ps(vy0,diff_dsin_halfdx);
+      }
+      _mm256_storeu_ps(work.ux+a,uxa);
+      _mm256_storeu_ps(work.uy+a,uya);
+      _mm256_storeu_ps(work.ux+b,uxb);
+      _mm256_storeu_ps(work.uy+b,uyb);
+      _mm256_storeu_ps(work.vx+a,vxa);
+      _mm256_storeu_ps(work.vy+a,vya);
+      _mm256_storeu_ps(work.vx+b,vxb);
+      _mm256_storeu_ps(work.vy+b,vyb);
+
+      // compute the moment arms relative to the minus- and plus- blocks
+      __m256 sinm_d3 = _mm256_mul_ps(sinm_halfdx,divsqrt3);
+      __m256 cosm_d3 = _mm256_mul_ps(cosm_halfdx,divsqrt3);
+      __m256 sinp_d3 = _mm256_mul_ps(sinp_halfdx,divsqrt3);
+      __m256 cosp_d3 = _mm256_mul_ps(cosp_halfdx,divsqrt3);
+      if (dir == Orientation::X) {
+	_mm256_storeu_ps(work.rxm+a,_mm256_add_ps(_mm256_add_ps(cosm_halfdx,sinm_d3),_mm256_mul_ps(half,uxa)));
+	_mm256_storeu_ps(work.rym+a,_mm256_add_ps(_mm256_sub_ps(sinm_halfdx,cosm_d3),_mm256_mul_ps(half,uya)));
+	_mm256_storeu_ps(work.rxm+b,_mm256_add_ps(_mm256_sub_ps(cosm_halfdx,sinm_d3),_mm256_mul_ps(half,uxb)));
+	_mm256_storeu_ps(work.rym+b,_mm256_add_ps(_mm256_add_ps(sinm_halfdx,cosm_d3),_mm256_mul_ps(half,uyb)));
+	_mm256_storeu_ps(work.rxp+a,_mm256_sub_ps(_mm256_sub_ps(sinp_d3,cosp_halfdx),_mm256_mul_ps(half,uxa)));
+	_mm256_storeu_ps(work.ryp+a,_mm256_sub_ps(_mm256_sub_ps(_mm256_xor_ps(sinp_halfdx,signbit),cosp_d3),_mm256_mul_ps(half,uya)));
+	_mm256_storeu_ps(work.rxp+b,_mm256_sub_ps(_mm256_sub_ps(_mm256_xor_ps(cosp_halfdx,signbit),sinp_d3),_mm256_mul_ps(half,uxb)));
+	_mm256_storeu_ps(work.ryp+b,_mm256_sub_ps(_mm256_sub_ps(cosp_d3,sinp_halfdx),_mm256_mul_ps(half,uyb)));
+      } else {
+	_mm256_storeu_ps(work.rxm+a,_mm256_add_ps(_mm256_sub_ps(cosm_d3,sinm_halfdx),_mm256_mul_ps(half,uxa)));
+	_mm256_storeu_ps(work.rym+a,_mm256_add_ps(_mm256_add_ps(cosm_halfdx,sinm_d3),_mm256_mul_ps(half,uya)));
+	_mm256_storeu_ps(work.rxm+b,_mm256_add_ps(_mm256_sub_ps(_mm256_xor_ps(sinm_halfdx,signbit),cosm_d3),_mm256_mul_ps(half,uxb)));
+	_mm256_storeu_ps(work.rym+b,_mm256_add_ps(_mm256_sub_ps(cosm_halfdx,sinm_d3),_mm256_mul_ps(half,uyb)));
+	_mm256_storeu_ps(work.rxp+a,_mm256_sub_ps(_mm256_add_ps(sinp_halfdx,cosp_d3),_mm256_mul_ps(half,uxa)));
+	_mm256_storeu_ps(work.ryp+a,_mm256_sub_ps(_mm256_sub_ps(sinp_d3,cosp_halfdx),_mm256_mul_ps(half,uya)));
+	_mm256_storeu_ps(work.rxp+b,_mm256_sub_ps(_mm256_sub_ps(sinp_halfdx,cosp_d3),_mm256_mul_ps(half,uxb)));
+	_mm256_storeu_ps(work.ryp+b,_mm256_sub_ps(_mm256_sub_ps(_mm256_xor_ps(cosp_halfdx,signbit),sinp_d3),_mm256_mul_ps(half,uyb)));
+      }
+    } // for i = ...
+  } // computeKinematicsAVX2()
+
+  __attribute__((target("avx2")))
+  void scatterForcesAVX2(const std::pair<int,int>* faceIDs, const int* faces, int count, const int* dropped, float dx_, float halfdx_) {
+    const __m256 dx     = _mm256_set1_ps(dx_);
+    const __m256 halfdx = _mm256_set1_ps(halfdx_);
+    for (int i = 0; i < count; i++) {
+      int m = LANES*faceIDs[faces[i]].first;
+      int p = LANES*faceIDs[faces[i]].second;
+      int a = LANES*(2*i);
+      int b = LANES*(2*i+1);
+      __m256 active = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(dropped+LANES*faces[i])),_mm256_setzero_si256()));
+      __m256 txa = _mm256_loadu_ps(work.tx+a);
+      __m256 tya = _mm256_loadu_ps(work.ty+a);
+      __m256 txb = _mm256_loadu_ps(work.tx+b);
+      __m256 tyb = _mm256_loadu_ps(work.ty+b);
+      __m256 fxi = _mm256_mul_ps(_mm256_add_ps(txa,txb),dx);
+      __m256 fyi = _mm256_mul_ps(_mm256_add_ps(tya,tyb),dx);
+      __m256 mzm = _mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_loadu_ps(work.rxm+a),tya),_mm256_mul_ps(_mm256_loadu_ps(work.rym+a),txa)),
+								    _mm256_mul_ps(_mm256_loadu_ps(work.rxm+b),tyb)),_mm256_mul_ps(_mm256_loadu_ps(work.rym+b),txb)),halfdx);
+      __m256 mzp = _mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_loadu_ps(work.rxp+a),tya),_mm256_mul_ps(_mm256_loadu_ps(work.ryp+a),txa)),
+								    _mm256_mul_ps(_mm256_loadu_ps(work.rxp+b),tyb)),_mm256_mul_ps(_mm256_loadu_ps(work.ryp+b),txb)),halfdx);
+      __m256 f;
+      f = _mm256_loadu_ps(&fx[m]); _mm256_storeu_ps(&fx[m],_mm256_blendv_ps(f,_mm256_add_ps(f,fxi),active));
+      f = _mm256_loadu_ps(&fy[m]); _mm256_storeu_ps(&fy[m],_mm256_blendv_ps(f,_mm256_add_ps(f,fyi),active));
+      f = _mm256_loadu_ps(&fx[p]); _mm256_storeu_ps(&fx[p],_mm256_blendv_ps(f,_mm256_sub_ps(f,fxi),active));
+      f = _mm256_loadu_ps(&fy[p]); _mm256_storeu_ps(&fy[p],_mm256_blendv_ps(f,_mm256_sub_ps(f,fyi),active));
+      f = _mm256_loadu_ps(&mz[m]); _mm256_storeu_ps(&mz[m],_mm256_blendv_ps(f,_mm256_add_ps(f,mzm),active));
+      f = _mm256_loadu_ps(&mz[p]); _mm256_storeu_ps(&mz[p],_mm256_blendv_ps(f,_mm256_sub_ps(f,mzp),active));
+    } // for i = ...
+  } // scatterForcesAVX2()
+#endif // CZM_BATCH_SIMD_X86
+
+  // contact of the fragments of each lane, evaluated by the blocks of its run (whose bonds and Verlet list
+  // are those of the lane); the lane state is copied in and the forces out only while the lane has fragments
+  void applyContactForces(void) {
+    for (int k = 0; k < LANES; k++) {
+      if ((run[k] == nullptr) || (run[k]->blocks.Nfragments == 0)) continue;
+      Blocks& blocks = run[k]->blocks;
+      for (int i = 0; i < Nblocks; i++) {
+	int n = LANES*i+k;
+	blocks.px[i] = px[n];
+	blocks.py[i] = py[n];
+	blocks.cz[i] = cz[n];
+	blocks.sz[i] = sz[n];
+	blocks.vx[i] = vx[n];
+	blocks.vy[i] = vy[n];
+	blocks.wz[i] = wz[n];
+	blocks.fx[i] = fx[n];
+	blocks.fy[i] = fy[n];
+	blocks.mz[i] = mz[n];
+      } // for i = ...
+      blocks.applyContactForces();
+      for (int i = 0; i < Nblocks; i++) {
+	int n = LANES*i+k;
+	fx[n] = blocks.fx[i];
+	fy[n] = blocks.fy[i];
+	mz[n] = blocks.mz[i];
+      } // for i = ...
+    } // for k = ...
+  } // applyContactForces()
+
+  // integrate the block positions of all lanes in time, then set the forces of the next substep to the
+  // external loads (as Blocks::integrateSlice, advancePosition and setExternalLoads)
+  void integrate(Scalar dt) {
+    Scalar bx = 0.0;
+    Scalar by = -gravity;
+    for (int i = 0; i < Nblocks; i++) {
+      for (int k = 0; k < LANES; k++) {
+	int n = LANES*i+k;
+	vx[n] += dt * imass[i] * fx[n];
+	vy[n] += dt * imass[i] * fy[n];
+	wz[n] += dt * iinertia[i] * mz[n];
+	vx[n] *= fixity[i];
+	vy[n] *= fixity[i];
+	wz[n] *= fixity[i];
+	px[n] += dt * vx[n];
+	py[n] += dt * vy[n];
+	Scalar h = 0.5 * dt * wz[n];
+	Scalar c = cz[n]*(1.0f-h*h) - sz[n]*(2.0f*h);
+	Scalar s = sz[n]*(1.0f-h*h) + cz[n]*(2.0f*h);
+	Scalar inorm = 1.0f / sqrt(c*c + s*s);
+	cz[n] = c * inorm;
+	sz[n] = s * inorm;
+	fx[n] = mass[i] * bx;
+	fy[n] = mass[i] * by;
+	mz[n] = 0.0;
+	if (drag_coefficient != 0.0) {
+	  Scalar drag_force = drag_coefficient * (vx[n]*vx[n] + vy[n]*vy[n]);
+	  Scalar drag_moment = drag_coefficient * (wz[n]*wz[n]);
+	  fx[n] -= drag_force * vx[n];
+	  fy[n] -= drag_force * vy[n];
+	  mz[n] -= drag_moment * wz[n];
+	} // if (drag_coefficient != 0.0)
+      } // for k = ...
+    } // for i = ...
+  } // integrate()
+
+  // number of faces per chunk of the face pass (the workspace then occupies 13 KB, as for CohesiveZone)
+  static const int CHUNK_SIZE = 16;
+
+  struct Workspace {
+    Scalar nx[2*CHUNK_SIZE*LANES];
+    Scalar ny[2*CHUNK_SIZE*LANES];
+    Scalar ux[2*CHUNK_SIZE*LANES];
+    Scalar uy[2*CHUNK_SIZE*LANES];
+    Scalar vx[2*CHUNK_SIZE*LANES];
+    Scalar vy[2*CHUNK_SIZE*LANES];
+    Scalar tx[2*CHUNK_SIZE*LANES];
+    Scalar ty[2*CHUNK_SIZE*LANES];
+    Scalar rxm[2*CHUNK_SIZE*LANES];
+    Scalar rym[2*CHUNK_SIZE*LANES];
+    Scalar rxp[2*CHUNK_SIZE*LANES];
+    Scalar ryp[2*CHUNK_SIZE*LANES];
+    int   ids[2*CHUNK_SIZE*LANES];
+  }; // Workspace
+
+  // shared layout
+  int Nblocks = 0;
+  Scalar L = 1.0;
+  std::vector<Scalar> mass;
+  std::vector<Scalar> imass;
+  std::vector<Scalar> iinertia;
+  std::vector<Scalar> fixity;
+  std::vector<int> boundary;
+  float gravity = 0.0;
+  float drag_coefficient = 0.0;
+  std::vector<Zone> zones;
+
+  // lane state ([block][lane])
+  std::vector<Coordinate> px;
+  std::vector<Coordinate> py;
+  std::vector<Scalar> cz;
+  std::vector<Scalar> sz;
+  std::vector<Scalar> vx;
+  std::vector<Scalar> vy;
+  std::vector<Scalar> wz;
+  std::vector<Scalar> fx;
+  std::vector<Scalar> fy;
+  std::vector<Scalar> mz;
+
+  Workspace work;
+  std::vector<std::pair<int,int> > failedFaces;
+}; // ScenarioBatch
+
+#endif // SCENARIO_BATCH_H
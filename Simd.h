@@ -0,0 +1,53 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cstdlib>
+#include <cstring>
+
+// explicit x86 SIMD kernels are compiled with per-function target attributes,
+// so that a single binary can dispatch to the widest instruction set at run time.
+// (build with -ffp-contract=off: otherwise the AVX-512 kernels may be contracted
+// into FMAs and no longer reproduce the scalar kernels bit for bit). The kernels are single precision, so
+// double precision builds (CZM_DOUBLE, see Precision.h) use the scalar kernels
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__)) && !defined(__EMSCRIPTEN__) && !defined(CZM_NO_SIMD) && !defined(CZM_DOUBLE)
+#define CZM_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// GCC before 13 reports '__Y' may be used uninitialized from avx512fintrin.h in every AVX-512 kernel, as its
+// intrinsics pass _mm512_undefined_ps() as the (unused) source of their full-mask builtins (GCC bug 105593); the
+// warning is silenced around the AVX-512 kernels only
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ < 13)
+#define CZM_AVX512_BEGIN _Pragma("GCC diagnostic push") _Pragma("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+#define CZM_AVX512_END _Pragma("GCC diagnostic pop")
+#else
+#define CZM_AVX512_BEGIN
+#define CZM_AVX512_END
+#endif
+
+enum class SimdLevel { SCALAR, AVX2, AVX512 };
+
+inline SimdLevel detectSimdLevel(void) {
+  SimdLevel level = SimdLevel::SCALAR;
+#ifdef CZM_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) level = SimdLevel::AVX2;
+  if (__builtin_cpu_supports("avx512f")) level = SimdLevel::AVX512;
+#endif
+
+  // optionally cap the instruction set (e.g. CZM_SIMD=scalar) for testing or to avoid frequency throttling
+  const char* request = getenv("CZM_SIMD");
+  if (request != nullptr) {
+    if ((strcmp(request,"scalar") == 0)) level = SimdLevel::SCALAR;
+    if ((strcmp(request,"avx2") == 0) && (level == SimdLevel::AVX512)) level = SimdLevel::AVX2;
+  } // if (request != nullptr)
+  return level;
+} // detectSimdLevel()
+
+// widest instruction set supported by the current CPU (detected once)
+inline SimdLevel simdLevel(void) {
+  static const SimdLevel level = detectSimdLevel();
+  return level;
+} // simdLevel()
+
+#endif // SIMD_H
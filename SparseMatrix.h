@@ -0,0 +1,191 @@
+#ifndef SPARSE_MATRIX_H
+#define SPARSE_MATRIX_H
+
+#include "ThreadPool.h"
+#include "Precision.h"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+// Symmetric positive definite matrix with 3x3 blocks, one block row and column per rigid block (its x, y and
+// rotation degrees of freedom), stored in block-CSR form over the block adjacency. Systems are solved by the
+// conjugate gradient method, preconditioned by the inverses of the 3x3 diagonal blocks (block Jacobi)
+class BlockSparseMatrix {
+public:
+
+  // set the sparsity pattern: a diagonal block for every row, and the blocks (i,j) and (j,i) for each coupled pair
+  void initialize(int newRows, const std::vector<std::pair<int,int> >& pairs) {
+    Nrows = newRows;
+    rowStart.assign(Nrows+1, 1);
+    rowStart[0] = 0;
+    for (auto pair : pairs) {
+      rowStart[pair.first+1]++;
+      rowStart[pair.second+1]++;
+    } // for pair = ...
+    for (int i = 0; i < Nrows; i++) rowStart[i+1] += rowStart[i];
+
+    // fill in the columns of each row, then sort them (the diagonal block included)
+    columns.resize(rowStart[Nrows]);
+    std::vector<int> next(rowStart.begin(), rowStart.end()-1);
+    for (int i = 0; i < Nrows; i++) columns[next[i]++] = i;
+    for (auto pair : pairs) {
+      columns[next[pair.first]++]  = pair.second;
+      columns[next[pair.second]++] = pair.first;
+    } // for pair = ...
+    for (int i = 0; i < Nrows; i++) std::sort(columns.begin()+rowStart[i], columns.begin()+rowStart[i+1]);
+    values.assign(9*columns.size(), 0.0);
+    idiagonal.assign(9*Nrows, 0.0);
+  } // initialize()
+
+  void zero(void) {
+    std::fill(values.begin(), values.end(), 0.0);
+  } // zero()
+
+  // 3x3 block (i,j), stored row by row (the block must be part of the sparsity pattern)
+  Scalar* block(int i, int j) {
+    int k = rowStart[i];
+    while (columns[k] != j) k++;
+    return &values[9*k];
+  } // block()
+
+  // y = A x
+  void multiply(const std::vector<Scalar>& x, std::vector<Scalar>& y, ThreadPool* pool) {
+    forEachSlice(pool, [&](int begin, int end) {
+      for (int i = begin; i < end; i++) {
+	Scalar y0 = 0.0;
+	Scalar y1 = 0.0;
+	Scalar y2 = 0.0;
+	for (int k = rowStart[i]; k < rowStart[i+1]; k++) {
+	  const Scalar* a = &values[9*k];
+	  const Scalar* xj = &x[3*columns[k]];
+	  y0 += a[0]*xj[0] + a[1]*xj[1] + a[2]*xj[2];
+	  y1 += a[3]*xj[0] + a[4]*xj[1] + a[5]*xj[2];
+	  y2 += a[6]*xj[0] + a[7]*xj[1] + a[8]*xj[2];
+	} // for k = ...
+	y[3*i]   = y0;
+	y[3*i+1] = y1;
+	y[3*i+2] = y2;
+      } // for i = ...
+    });
+  } // multiply()
+
+  // solve A x = b for x (starting from the given x) until the residual has been reduced by the relative tolerance;
+  // returns the number of iterations taken. The dot products are summed per slice of rows in a fixed order,
+  // so that the result does not depend on the number of threads
+  int solve(const std::vector<Scalar>& b, std::vector<Scalar>& x, Scalar tolerance, int maxIterations, ThreadPool* pool) {
+    int N = 3*Nrows;
+    r.resize(N);
+    z.resize(N);
+    p.resize(N);
+    q.resize(N);
+    invertDiagonal();
+
+    multiply(x, q, pool);
+    for (int i = 0; i < N; i++) r[i] = b[i] - q[i];
+    precondition(r, z, pool);
+    p = z;
+    double rz = dot(r, z, pool);
+    double bnorm2 = dot(b, b, pool);
+    if (bnorm2 == 0.0) bnorm2 = 1.0;
+    int iteration = 0;
+    for (; iteration < maxIterations; iteration++) {
+      if (dot(r, r, pool) <= tolerance*tolerance*bnorm2) break;
+      multiply(p, q, pool);
+      double pq = dot(p, q, pool);
+      if (pq <= 0.0) break;
+      Scalar alpha = rz/pq;
+      forEachSlice(pool, [&](int begin, int end) {
+	for (int i = 3*begin; i < 3*end; i++) {
+	  x[i] += alpha*p[i];
+	  r[i] -= alpha*q[i];
+	} // for i = ...
+      });
+      precondition(r, z, pool);
+      double rzNew = dot(r, z, pool);
+      Scalar beta = rzNew/rz;
+      rz = rzNew;
+      forEachSlice(pool, [&](int begin, int end) {
+	for (int i = 3*begin; i < 3*end; i++) p[i] = z[i] + beta*p[i];
+      });
+    } // for iteration = ...
+    return iteration;
+  } // solve()
+
+  int Nrows = 0;
+  std::vector<int> rowStart; // block-CSR row pointers
+  std::vector<int> columns;  // block column of each stored block
+  std::vector<Scalar> values; // 9 values per stored block
+
+private:
+
+  // invert the diagonal blocks (by their cofactors)
+  void invertDiagonal(void) {
+    for (int i = 0; i < Nrows; i++) {
+      const Scalar* a = block(i,i);
+      double c0 = double(a[4])*a[8] - double(a[5])*a[7];
+      double c1 = double(a[5])*a[6] - double(a[3])*a[8];
+      double c2 = double(a[3])*a[7] - double(a[4])*a[6];
+      double det = a[0]*c0 + a[1]*c1 + a[2]*c2;
+      double idet = (det != 0.0) ? 1.0/det : 0.0;
+      Scalar* inv = &idiagonal[9*i];
+      inv[0] = c0*idet;
+      inv[1] = (double(a[2])*a[7] - double(a[1])*a[8])*idet;
+      inv[2] = (double(a[1])*a[5] - double(a[2])*a[4])*idet;
+      inv[3] = c1*idet;
+      inv[4] = (double(a[0])*a[8] - double(a[2])*a[6])*idet;
+      inv[5] = (double(a[2])*a[3] - double(a[0])*a[5])*idet;
+      inv[6] = c2*idet;
+      inv[7] = (double(a[1])*a[6] - double(a[0])*a[7])*idet;
+      inv[8] = (double(a[0])*a[4] - double(a[1])*a[3])*idet;
+    } // for i = ...
+  } // invertDiagonal()
+
+  void precondition(const std::vector<Scalar>& r, std::vector<Scalar>& z, ThreadPool* pool) {
+    forEachSlice(pool, [&](int begin, int end) {
+      for (int i = begin; i < end; i++) {
+	const Scalar* inv = &idiagonal[9*i];
+	const Scalar* ri = &r[3*i];
+	z[3*i]   = inv[0]*ri[0] + inv[1]*ri[1] + inv[2]*ri[2];
+	z[3*i+1] = inv[3]*ri[0] + inv[4]*ri[1] + inv[5]*ri[2];
+	z[3*i+2] = inv[6]*ri[0] + inv[7]*ri[1] + inv[8]*ri[2];
+      } // for i = ...
+    });
+  } // precondition()
+
+  double dot(const std::vector<Scalar>& a, const std::vector<Scalar>& b, ThreadPool* pool) {
+    int Nslices = (Nrows + SLICE_SIZE - 1) / SLICE_SIZE;
+    partial.assign(Nslices, 0.0);
+    forEachSlice(pool, [&](int begin, int end) {
+      double sum = 0.0;
+      for (int i = 3*begin; i < 3*end; i++) sum += double(a[i])*b[i];
+      partial[begin/SLICE_SIZE] = sum;
+    });
+    double sum = 0.0;
+    for (double s : partial) sum += s;
+    return sum;
+  } // dot()
+
+  // call task(begin, end) for contiguous slices of rows, in parallel if a thread pool is given
+  template <class Task>
+  void forEachSlice(ThreadPool* pool, Task task) {
+    int Nslices = (Nrows + SLICE_SIZE - 1) / SLICE_SIZE;
+    if (pool == nullptr) {
+      for (int slice = 0; slice < Nslices; slice++) task(slice*SLICE_SIZE, std::min(Nrows, (slice+1)*SLICE_SIZE));
+      return;
+    }
+    pool->parallelFor(Nslices, [&](int thread, int slice) {
+      task(slice*SLICE_SIZE, std::min(Nrows, (slice+1)*SLICE_SIZE));
+    });
+  } // forEachSlice()
+
+  static const int SLICE_SIZE = 1024;
+
+  std::vector<Scalar> idiagonal; // inverse diagonal blocks (preconditioner)
+  std::vector<Scalar> r;         // (conjugate gradient work vectors)
+  std::vector<Scalar> z;
+  std::vector<Scalar> p;
+  std::vector<Scalar> q;
+  std::vector<double> partial;
+}; // BlockSparseMatrix
+
+#endif // SPARSE_MATRIX_H
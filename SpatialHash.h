@@ -0,0 +1,126 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include "Precision.h"
+#include "Checkpoint.h"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+// Uniform-grid broadphase over a set of points (e.g. block centers): each point is binned into the square
+// cell containing it, and the cells are hashed into a fixed number of buckets. Points are only moved between
+// buckets when they cross a cell boundary, so that updating the hash after a time step is cheap.
+class SpatialHash {
+public:
+
+  // (re-)bin all points into cells of the given size
+  void initialize(float cellSize, const std::vector<Coordinate>& px, const std::vector<Coordinate>& py) {
+    divCellSize = 1.0/cellSize;
+    int Npoints = px.size();
+    int Nbuckets = 16;
+    while (Nbuckets < 2*Npoints) Nbuckets *= 2;
+    mask = Nbuckets-1;
+    buckets.assign(Nbuckets, std::vector<int>());
+    cellX.resize(Npoints);
+    cellY.resize(Npoints);
+    slot.resize(Npoints);
+    for (int i = 0; i < Npoints; i++) {
+      cellX[i] = cell(px[i]);
+      cellY[i] = cell(py[i]);
+      insert(i);
+    } // for i = ...
+  } // initialize()
+
+  // move the points that have left their cell since the last update
+  void update(const std::vector<Coordinate>& px, const std::vector<Coordinate>& py) {
+    int Npoints = px.size();
+    for (int i = 0; i < Npoints; i++) {
+      int ix = cell(px[i]);
+      int iy = cell(py[i]);
+      if ((ix != cellX[i]) || (iy != cellY[i])) {
+	remove(i);
+	cellX[i] = ix;
+	cellY[i] = iy;
+	insert(i);
+      } // if (cell changed)
+    } // for i = ...
+  } // update()
+
+  // call visit(i) for every point whose cell lies within range cells of the cell containing (x,y)
+  template <class Visit>
+  void query(Coordinate x, Coordinate y, int range, Visit visit) const {
+    int ix = cell(x);
+    int iy = cell(y);
+    for (int jy = iy-range; jy <= iy+range; jy++) {
+      for (int jx = ix-range; jx <= ix+range; jx++) {
+	for (int i : buckets[hash(jx,jy)]) {
+	  // (distinct cells may share a bucket)
+	  if ((cellX[i] == jx) && (cellY[i] == jy)) visit(i);
+	} // for i = ...
+      } // for jx = ...
+    } // for jy = ...
+  } // query()
+
+  int size(void) const {
+    return cellX.size();
+  } // size()
+
+  // save or restore the binning (the order of the points within each bucket determines the order in which
+  // queries visit them, so it is kept rather than rebuilt)
+  void checkpoint(Checkpoint& checkpoint) {
+    std::vector<int> bucketStart;
+    std::vector<int> points;
+    if (checkpoint.saving()) {
+      bucketStart.push_back(0);
+      for (const std::vector<int>& bucket : buckets) {
+	points.insert(points.end(), bucket.begin(), bucket.end());
+	bucketStart.push_back(points.size());
+      } // for bucket = ...
+    }
+    checkpoint.value(divCellSize);
+    checkpoint.value(mask);
+    checkpoint.array(cellX);
+    checkpoint.array(cellY);
+    checkpoint.array(slot);
+    checkpoint.array(bucketStart);
+    checkpoint.array(points);
+    if (!checkpoint.saving() && checkpoint.ok && !bucketStart.empty()) {
+      buckets.assign(bucketStart.size()-1, std::vector<int>());
+      for (int b = 0; b < int(buckets.size()); b++) buckets[b].assign(points.begin()+bucketStart[b], points.begin()+bucketStart[b+1]);
+    }
+  } // checkpoint()
+
+private:
+
+  inline int cell(Coordinate x) const {
+    // (clamped, so that diverging coordinates still map to a valid cell)
+    return int(floor(std::max(Coordinate(-1.0e+9), std::min(Coordinate(1.0e+9), x*divCellSize))));
+  } // cell()
+
+  inline int hash(int ix, int iy) const {
+    return ((unsigned(ix)*73856093u) ^ (unsigned(iy)*19349663u)) & mask;
+  } // hash()
+
+  void insert(int i) {
+    std::vector<int>& bucket = buckets[hash(cellX[i],cellY[i])];
+    slot[i] = bucket.size();
+    bucket.push_back(i);
+  } // insert()
+
+  void remove(int i) {
+    std::vector<int>& bucket = buckets[hash(cellX[i],cellY[i])];
+    int last = bucket.back();
+    bucket[slot[i]] = last;
+    slot[last] = slot[i];
+    bucket.pop_back();
+  } // remove()
+
+  float divCellSize = 1.0;
+  unsigned mask = 0;
+  std::vector<std::vector<int> > buckets;
+  std::vector<int> cellX; // cell of each point
+  std::vector<int> cellY;
+  std::vector<int> slot;  // position of each point within its bucket
+}; // SpatialHash
+
+#endif // SPATIAL_HASH_H
@@ -0,0 +1,119 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+
+// A fixed set of persistent worker threads executing fork-join parallel loops.
+// The calling thread participates as thread 0, so a pool of size 1 spawns no
+// workers and runs every loop serially.
+class ThreadPool {
+public:
+
+  ThreadPool() {
+    nthreads = 1;
+    generation = 0;
+    count = 0;
+    busy = 0;
+    stop = false;
+  } // ThreadPool()
+
+  ~ThreadPool() {
+    resize(1);
+  } // ~ThreadPool()
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int size(void) {
+    return nthreads;
+  } // size()
+
+  void resize(int newThreads) {
+    if (newThreads < 1) newThreads = std::max(1, int(std::thread::hardware_concurrency()));
+    if (newThreads == nthreads) return;
+
+    // join existing workers
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      stop = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) worker.join();
+    workers.clear();
+    stop = false;
+
+    // launch new workers (thread ids 1 ... newThreads-1)
+    nthreads = newThreads;
+    for (int thread = 1; thread < nthreads; thread++) {
+      workers.push_back(std::thread(&ThreadPool::work, this, thread));
+    } // for thread = ...
+  } // resize()
+
+  // call task(thread, i) for all i in [0,n), distributing the indices dynamically
+  // over all threads; returns once every index has been processed
+  template <class Task>
+  void parallelFor(int n, Task task) {
+    if ((nthreads == 1) || (n <= 1)) {
+      for (int i = 0; i < n; i++) task(0, i);
+      return;
+    }
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      current = task;
+      count = n;
+      next = 0;
+      busy = nthreads - 1;
+      generation++;
+    }
+    wake.notify_all();
+    run(0);
+
+    // wait for the workers to finish their last indices
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return (busy == 0); });
+  } // parallelFor()
+
+private:
+
+  void run(int thread) {
+    for (int i = next++; i < count; i = next++) current(thread, i);
+  } // run()
+
+  void work(int thread) {
+    long seen = 0;
+    while (true) {
+      {
+	std::unique_lock<std::mutex> lock(mutex);
+	wake.wait(lock, [this,seen] { return stop || (generation != seen); });
+	if (stop) return;
+	seen = generation;
+      }
+      run(thread);
+      {
+	std::unique_lock<std::mutex> lock(mutex);
+	busy--;
+      }
+      done.notify_one();
+    } // while (true)
+  } // work()
+
+  int nthreads;
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  std::function<void(int,int)> current;
+  std::atomic<int> next;
+  long generation;
+  int count;
+  int busy;
+  bool stop;
+}; // ThreadPool
+
+#endif // THREAD_POOL_H
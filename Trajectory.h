@@ -0,0 +1,375 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include "Blocks.h"
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+// Compressed trajectory of the blocks (position and rotation angle of every block at each recorded frame).
+// The coordinates are quantized to fixed steps, and the frames are grouped into chunks of keyframeInterval
+// frames: the first frame of a chunk stores the quantized values themselves, and every other frame the
+// differences from the previous frame (zigzag varints, all x, then all y, then all angles, so that the small,
+// similar deltas of a slowly moving region form long runs). Each chunk is then compressed with a byte-oriented
+// LZ77 codec (the LZ4 block format). An index of the chunks and frame times is written at the end of the file,
+// so that the reader seeks to any frame by decoding a single chunk, whatever the length of the file.
+//
+// File layout: a Header, the compressed chunks, the chunk index (Chunk records), the frame times (doubles),
+// and a Footer locating the index
+namespace Trajectory {
+
+  struct Header {
+    char magic[8];            // "CZMTRAJ1"
+    uint32_t Nblocks;
+    uint32_t keyframeInterval;
+    double positionQuantum;   // quantization steps of the positions and rotation angles
+    double angleQuantum;
+  }; // Header
+
+  struct Chunk {
+    uint64_t offset;          // file offset of the compressed chunk
+    uint32_t compressedSize;
+    uint32_t size;            // bytes of the encoded (uncompressed) chunk
+    uint32_t firstFrame;
+    uint32_t frames;
+  }; // Chunk
+
+  struct Footer {
+    uint64_t indexOffset;
+    uint32_t Nchunks;
+    uint32_t Nframes;
+    char magic[8];            // "CZMTRAJ1"
+  }; // Footer
+
+  // LZ77 compression in the LZ4 block format: sequences of a token (literal length, match length - 4), the
+  // literals, and a 16-bit match offset; lengths of 15 or more continue in the following bytes
+  inline void compress(const std::vector<uint8_t>& input, std::vector<uint8_t>& output) {
+    const int HASH_BITS = 14;
+    const int MIN_MATCH = 4;
+    const int MAX_OFFSET = 65535;
+    std::vector<int> table(1 << HASH_BITS, -1);
+    int size = input.size();
+    const uint8_t* in = input.data();
+    output.clear();
+    output.reserve(size + size/255 + 16);
+    auto length = [&](int value) {
+      for (; value >= 255; value -= 255) output.push_back(255);
+      output.push_back(value);
+    };
+    auto hash = [&](int i) {
+      uint32_t word;
+      memcpy(&word, in+i, 4);
+      return (word * 2654435761u) >> (32 - HASH_BITS);
+    };
+    int anchor = 0;
+    int i = 0;
+    // (the last bytes are always emitted as literals, as in LZ4)
+    int limit = size - 12;
+    while (i < limit) {
+      uint32_t h = hash(i);
+      int candidate = table[h];
+      table[h] = i;
+      if ((candidate < 0) || ((i - candidate) > MAX_OFFSET) || (memcmp(in+candidate, in+i, MIN_MATCH) != 0)) {
+	i++;
+	continue;
+      }
+      int match = MIN_MATCH;
+      while (((i + match) < (size - 5)) && (in[candidate+match] == in[i+match])) match++;
+
+      // emit the sequence
+      int literals = i - anchor;
+      output.push_back((std::min(literals, 15) << 4) | std::min(match - MIN_MATCH, 15));
+      if (literals >= 15) length(literals - 15);
+      output.insert(output.end(), in+anchor, in+i);
+      int offset = i - candidate;
+      output.push_back(offset & 0xff);
+      output.push_back(offset >> 8);
+      if ((match - MIN_MATCH) >= 15) length(match - MIN_MATCH - 15);
+      i += match;
+      anchor = i;
+    } // while (i < limit)
+    int literals = size - anchor;
+    output.push_back(std::min(literals, 15) << 4);
+    if (literals >= 15) length(literals - 15);
+    output.insert(output.end(), in+anchor, in+size);
+  } // compress()
+
+  // returns false if the input is not a valid block of the given decompressed size
+  inline bool decompress(const uint8_t* in, int inputSize, std::vector<uint8_t>& output, int size) {
+    output.resize(size);
+    uint8_t* out = output.data();
+    int i = 0;
+    int o = 0;
+    auto length = [&](int value) {
+      while (i < inputSize) {
+	uint8_t byte = in[i++];
+	value += byte;
+	if (byte != 255) break;
+      } // while (i < inputSize)
+      return value;
+    };
+    while (i < inputSize) {
+      uint8_t token = in[i++];
+      int literals = token >> 4;
+      if (literals == 15) literals = length(literals);
+      if (((i + literals) > inputSize) || ((o + literals) > size)) return false;
+      memcpy(out+o, in+i, literals);
+      i += literals;
+      o += literals;
+      if (i >= inputSize) break; // (the last sequence has no match)
+      if ((i + 2) > inputSize) return false;
+      int offset = in[i] | (in[i+1] << 8);
+      i += 2;
+      int match = token & 15;
+      if (match == 15) match = length(match);
+      match += 4;
+      if ((offset == 0) || (offset > o) || ((o + match) > size)) return false;
+      // (byte by byte: the match may overlap its own output)
+      for (int k = 0; k < match; k++, o++) out[o] = out[o-offset];
+    } // while (i < inputSize)
+    return (o == size);
+  } // decompress()
+
+  inline void putVarint(std::vector<uint8_t>& buffer, int32_t value) {
+    uint32_t zigzag = (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+    while (zigzag >= 0x80) {
+      buffer.push_back(uint8_t(zigzag | 0x80));
+      zigzag >>= 7;
+    } // while (zigzag >= 0x80)
+    buffer.push_back(uint8_t(zigzag));
+  } // putVarint()
+
+  inline int32_t getVarint(const uint8_t*& p, const uint8_t* end) {
+    uint32_t zigzag = 0;
+    for (int shift = 0; (p < end) && (shift < 35); shift += 7) {
+      uint8_t byte = *p++;
+      zigzag |= uint32_t(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) break;
+    } // for shift = ...
+    return int32_t(zigzag >> 1) ^ -int32_t(zigzag & 1);
+  } // getVarint()
+
+  inline int32_t quantize(double value, double quantum) {
+    double q = std::round(value / quantum);
+    return int32_t(std::max(-2147483647.0, std::min(2147483647.0, q)));
+  } // quantize()
+
+  class Writer {
+  public:
+
+    Writer() = default;
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    ~Writer() {
+      close();
+    } // ~Writer()
+
+    bool open(const std::string& filename, int Nblocks, int keyframeInterval = 32, double positionQuantum = 1.0e-4, double angleQuantum = 1.0e-4) {
+      close();
+      file = fopen(filename.c_str(), "wb");
+      if (file == nullptr) {
+	std::cerr << "ERROR: Unable to open trajectory file " << filename << std::endl;
+	return false;
+      }
+      memcpy(header.magic, "CZMTRAJ1", 8);
+      header.Nblocks = Nblocks;
+      header.keyframeInterval = std::max(1, keyframeInterval);
+      header.positionQuantum = positionQuantum;
+      header.angleQuantum = angleQuantum;
+      fwrite(&header, sizeof(header), 1, file);
+      offset = sizeof(header);
+      chunks.clear();
+      times.clear();
+      previous.assign(3*Nblocks, 0);
+      current.resize(3*Nblocks);
+      encoded.clear();
+      framesInChunk = 0;
+      return true;
+    } // open()
+
+    // append a frame of the current block positions and rotations
+    void addFrame(double time, const Blocks& blocks) {
+      if (file == nullptr) return;
+      int N = header.Nblocks;
+      for (int i = 0; i < N; i++) {
+	current[i]     = quantize(blocks.px[i], header.positionQuantum);
+	current[N+i]   = quantize(blocks.py[i], header.positionQuantum);
+	current[2*N+i] = quantize(atan2(blocks.sz[i], blocks.cz[i]), header.angleQuantum);
+      } // for i = ...
+      bool keyframe = (framesInChunk == 0);
+      for (int k = 0; k < 3*N; k++) putVarint(encoded, keyframe ? current[k] : (current[k] - previous[k]));
+      previous.swap(current);
+      times.push_back(time);
+      if (++framesInChunk == int(header.keyframeInterval)) flushChunk();
+    } // addFrame()
+
+    // write the last chunk and the index
+    void close(void) {
+      if (file == nullptr) return;
+      flushChunk();
+      Footer footer;
+      footer.indexOffset = offset;
+      footer.Nchunks = chunks.size();
+      footer.Nframes = times.size();
+      memcpy(footer.magic, "CZMTRAJ1", 8);
+      fwrite(chunks.data(), sizeof(Chunk), chunks.size(), file);
+      fwrite(times.data(), sizeof(double), times.size(), file);
+      fwrite(&footer, sizeof(footer), 1, file);
+      fclose(file);
+      file = nullptr;
+    } // close()
+
+    int frames(void) const {
+      return times.size();
+    } // frames()
+
+    // bytes written so far
+    uint64_t bytes(void) const {
+      return offset;
+    } // bytes()
+
+  private:
+
+    void flushChunk(void) {
+      if (framesInChunk == 0) return;
+      compress(encoded, compressed);
+      Chunk chunk;
+      chunk.offset = offset;
+      chunk.compressedSize = compressed.size();
+      chunk.size = encoded.size();
+      chunk.frames = framesInChunk;
+      chunk.firstFrame = times.size() - framesInChunk;
+      fwrite(compressed.data(), 1, compressed.size(), file);
+      offset += compressed.size();
+      chunks.push_back(chunk);
+      encoded.clear();
+      framesInChunk = 0;
+    } // flushChunk()
+
+    FILE* file = nullptr;
+    Header header;
+    uint64_t offset = 0;
+    std::vector<Chunk> chunks;
+    std::vector<double> times;
+    std::vector<int32_t> previous; // quantized values of the last frame
+    std::vector<int32_t> current;
+    std::vector<uint8_t> encoded;  // varints of the current chunk
+    std::vector<uint8_t> compressed;
+    int framesInChunk = 0;
+  }; // Writer
+
+  class Reader {
+  public:
+
+    Reader() = default;
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    ~Reader() {
+      close();
+    } // ~Reader()
+
+    // read the header and the index; returns false if the file is not a complete trajectory
+    bool open(const std::string& filename) {
+      close();
+      file = fopen(filename.c_str(), "rb");
+      Footer footer;
+      bool valid = (file != nullptr) && (fread(&header, sizeof(header), 1, file) == 1) && (memcmp(header.magic, "CZMTRAJ1", 8) == 0) &&
+	(fseek(file, -long(sizeof(footer)), SEEK_END) == 0) && (fread(&footer, sizeof(footer), 1, file) == 1) && (memcmp(footer.magic, "CZMTRAJ1", 8) == 0);
+      if (valid) {
+	chunks.resize(footer.Nchunks);
+	times.resize(footer.Nframes);
+	valid = (fseek(file, footer.indexOffset, SEEK_SET) == 0) &&
+	  (fread(chunks.data(), sizeof(Chunk), chunks.size(), file) == chunks.size()) &&
+	  (fread(times.data(), sizeof(double), times.size(), file) == times.size());
+      }
+      if (!valid) {
+	std::cerr << "ERROR: " << filename << " is not a complete trajectory file" << std::endl;
+	close();
+	return false;
+      }
+      loadedChunk = -1;
+      return true;
+    } // open()
+
+    void close(void) {
+      if (file != nullptr) fclose(file);
+      file = nullptr;
+    } // close()
+
+    int frames(void) const {
+      return times.size();
+    } // frames()
+
+    int blocks(void) const {
+      return header.Nblocks;
+    } // blocks()
+
+    double time(int frame) const {
+      return times[frame];
+    } // time()
+
+    // positions and rotation angles of all blocks at a frame (decoding only the chunk that contains it;
+    // the last decoded chunk is kept, so that consecutive frames are read without decompressing again)
+    bool readFrame(int frame, std::vector<float>& px, std::vector<float>& py, std::vector<float>& rz) {
+      if ((file == nullptr) || (frame < 0) || (frame >= frames())) return false;
+      int c = frame / header.keyframeInterval;
+      if (c != loadedChunk) {
+	const Chunk& chunk = chunks[c];
+	compressed.resize(chunk.compressedSize);
+	if ((fseek(file, chunk.offset, SEEK_SET) != 0) || (fread(compressed.data(), 1, compressed.size(), file) != compressed.size()) ||
+	    !decompress(compressed.data(), compressed.size(), encoded, chunk.size)) {
+	  std::cerr << "ERROR: Corrupt trajectory chunk " << c << std::endl;
+	  loadedChunk = -1;
+	  return false;
+	}
+	loadedChunk = c;
+	decodedFrame = -1;
+	position = encoded.data();
+      }
+
+      // accumulate the deltas up to the frame (continuing from the last decoded frame of this chunk if possible)
+      int N = header.Nblocks;
+      int first = chunks[c].firstFrame;
+      if ((decodedFrame < 0) || (frame < decodedFrame)) {
+	values.assign(3*N, 0);
+	position = encoded.data();
+	decodedFrame = first - 1;
+      }
+      const uint8_t* end = encoded.data() + encoded.size();
+      for (; decodedFrame < frame; decodedFrame++) {
+	for (int k = 0; k < 3*N; k++) values[k] += getVarint(position, end);
+      } // for decodedFrame = ...
+      px.resize(N);
+      py.resize(N);
+      rz.resize(N);
+      for (int i = 0; i < N; i++) {
+	px[i] = values[i] * header.positionQuantum;
+	py[i] = values[N+i] * header.positionQuantum;
+	rz[i] = values[2*N+i] * header.angleQuantum;
+      } // for i = ...
+      return true;
+    } // readFrame()
+
+  private:
+
+    FILE* file = nullptr;
+    Header header;
+    std::vector<Chunk> chunks;
+    std::vector<double> times;
+    std::vector<uint8_t> compressed;
+    std::vector<uint8_t> encoded;   // the last decoded chunk
+    std::vector<int32_t> values;    // quantized values of decodedFrame
+    const uint8_t* position = nullptr;
+    int loadedChunk = -1;
+    int decodedFrame = -1;
+  }; // Reader
+
+} // namespace Trajectory
+
+#endif // TRAJECTORY_H
@@ -0,0 +1,414 @@
+// Headless batch driver: loads a material layout and a ground motion record,
+// then integrates the cohesive zone model as fast as possible (no GL/GLUT/OpenAL)
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <filesystem>
+
+#include "CZM.h"
+#include "Trajectory.h"
+#include "Ensemble.h"
+
+using namespace std;
+
+void Usage(const char* program) {
+  cerr << "Usage: " << program << " --layout <file> --ux <PEER record> [options]" << endl
+       << "       " << program << " --layout <file> --ensemble <file> [options]" << endl
+       << "Options:" << endl
+       << "  --uy <PEER record>   vertical ground motion record" << endl
+       << "  --cache <0|1>        keep a binary copy of each record next to it for faster reloads (default 1)" << endl
+       << "  --catalog <dir>      list the PEER records in a directory (from their headers) and exit" << endl
+       << "  --spectra <file|dir> print the response spectra of every record listed in file (first field of each line) or of every" << endl
+       << "                       acceleration record of a catalog directory, concurrently on --threads, and exit" << endl
+       << "  --periods <list>     spectral periods in s, as \"T1,T2,...\" or \"min:max:n\" (n log-spaced periods; default 0.01:10:100)" << endl
+       << "  --damping <list>     spectral damping ratios, as \"z1,z2,...\" (default 0.05)" << endl
+       << "  --ensemble <file>    run the layout under every \"<ux record> <scale> [<uy record>]\" line of file, concurrently on --threads" << endl
+       << "                       (from the --restart state, if given), and print one summary line per run" << endl
+       << "  --lanes <n>          step up to 8 ensemble runs at once per thread, across SIMD lanes (needs --dt; default 1)" << endl
+       << "  --scale <s>          ground motion amplitude scale factor (default 10, cm to m)" << endl
+       << "  --timescale <s>      simulation time units per record second (default 50)" << endl
+       << "  --dt <dt>            integration substep size (default 0: automatic, from the stable time step)" << endl
+       << "  --safety <f>         fraction of the critical time step used when --dt is automatic (default 0.8)" << endl
+       << "  --levels <n>         finest multi-rate level when --dt is automatic (default 0: single rate)" << endl
+       << "  --implicit <s>       implicit integration, with substeps of s times the stable time step when --dt is automatic" << endl
+       << "  --substeps <n>       maximum number of substeps (default 1000000)" << endl
+       << "  --threads <n>        threads used to assemble the cohesive forces (default 1, 0: all cores)" << endl
+       << "  --assembly <mode>    parallel force assembly: colored (default) or gather" << endl
+       << "  --sleep <n>          put blocks to sleep after n substeps at rest (default 0: never)" << endl
+       << "  --clusters <f>       move blocks joined by elastic faces as rigid clusters, split at f of the face capacity (default 0: off)" << endl
+       << "  --check <n>          substeps between termination checks (default 500)" << endl
+       << "  --checkpoint <file>  save the simulation state to file at the end of the run" << endl
+       << "  --checkpoint-every <n> also save it every n substeps, at the next check (default 0: only at the end)" << endl
+       << "  --restart <file>     resume from a checkpoint saved with the same layout" << endl
+       << "  --record <file>      record the ground motion, base force and damage time histories (CSV, or binary for *.bin)" << endl
+       << "  --record-every <n>   substeps per recorded sample (default 1)" << endl
+       << "  --probe <block>      also record the position and velocity of a block (repeatable)" << endl
+       << "  --trajectory <file>  write the positions and rotations of all blocks to a compressed trajectory file" << endl
+       << "  --trajectory-every <n> substeps per trajectory frame (default 100)" << endl
+       << "  --ke-tol <e>         stop once shaking has ended and kinetic energy < e (default 1e-3)" << endl;
+} // Usage()
+
+// parse a list of values "v1,v2,..." or a log-spaced range "min:max:n"; returns false if it is malformed
+bool ParseList(const char* text, vector<float>& values) {
+  values.clear();
+  float low, high;
+  int n;
+  char end;
+  if (sscanf(text, "%f:%f:%d%c", &low, &high, &n, &end) == 3) {
+    if ((low <= 0.0) || (high < low) || (n < 1)) return false;
+    for (int i = 0; i < n; i++) values.push_back((n > 1) ? low*pow(double(high)/low, double(i)/(n-1)) : low);
+    return true;
+  }
+  istringstream fields(text);
+  string field;
+  while (getline(fields, field, ',')) {
+    char* last;
+    values.push_back(strtof(field.c_str(), &last));
+    if ((last == field.c_str()) || (*last != '\0')) return false;
+  } // while (getline(fields, field, ','))
+  return !values.empty();
+} // ParseList()
+
+int main(int argc, char** argv) {
+  const char* layout_file = nullptr;
+  const char* ux_file = nullptr;
+  const char* uy_file = nullptr;
+  bool cache = true;
+  const char* catalog_directory = nullptr;
+  const char* spectra_source = nullptr;
+  const char* periods_list = "0.01:10:100";
+  const char* damping_list = "0.05";
+  const char* ensemble_file = nullptr;
+  int lanes = 1;
+  float scale = 10.0;
+  float timescale = 50.0;
+  Coordinate dt = 0.0;
+  float safety = 0.8;
+  int levels = 0;
+  float implicit = 0.0;
+  int sleep_steps = 0;
+  float split_fraction = 0.0;
+  long max_substeps = 1000000;
+  long check_interval = 500;
+  const char* checkpoint_file = nullptr;
+  long checkpoint_interval = 0;
+  const char* restart_file = nullptr;
+  const char* record_file = nullptr;
+  int record_interval = 1;
+  vector<int> probe_blocks;
+  const char* trajectory_file = nullptr;
+  long trajectory_interval = 100;
+  float ke_tolerance = 1.0e-3;
+  int threads = 1;
+  const char* assembly = "colored";
+
+  // parse command line arguments
+  for (int i = 1; i < argc; i++) {
+    if ((i+1) >= argc) {
+      Usage(argv[0]);
+      return 1;
+    }
+    if      (strcmp(argv[i],"--layout")    == 0) layout_file    = argv[++i];
+    else if (strcmp(argv[i],"--ux")        == 0) ux_file        = argv[++i];
+    else if (strcmp(argv[i],"--uy")        == 0) uy_file        = argv[++i];
+    else if (strcmp(argv[i],"--cache")     == 0) cache          = (atoi(argv[++i]) != 0);
+    else if (strcmp(argv[i],"--catalog")   == 0) catalog_directory = argv[++i];
+    else if (strcmp(argv[i],"--spectra")   == 0) spectra_source = argv[++i];
+    else if (strcmp(argv[i],"--periods")   == 0) periods_list   = argv[++i];
+    else if (strcmp(argv[i],"--damping")   == 0) damping_list   = argv[++i];
+    else if (strcmp(argv[i],"--ensemble")  == 0) ensemble_file  = argv[++i];
+    else if (strcmp(argv[i],"--lanes")     == 0) lanes          = atoi(argv[++i]);
+    else if (strcmp(argv[i],"--scale")     == 0) scale          = atof(argv[++i]);
+    else if (strcmp(argv[i],"--timescale") == 0) timescale      = atof(argv[++i]);
+    else if (strcmp(argv[i],"--dt")        == 0) dt             = atof(argv[++i]);
+    else if (strcmp(argv[i],"--safety")    == 0) safety         = atof(argv[++i]);
+    else if (strcmp(argv[i],"--levels")    == 0) levels         = atoi(argv[++i]);
+    else if (strcmp(argv[i],"--implicit")  == 0) implicit       = atof(argv[++i]);
+    else if (strcmp(argv[i],"--substeps")  == 0) max_substeps   = atol(argv[++i]);
+    else if (strcmp(argv[i],"--threads")   == 0) threads        = atoi(argv[++i]);
+    else if (strcmp(argv[i],"--assembly")  == 0) assembly       = argv[++i];
+    else if (strcmp(argv[i],"--sleep")     == 0) sleep_steps    = atoi(argv[++i]);
+    else if (strcmp(argv[i],"--clusters")  == 0) split_fraction = atof(argv[++i]);
+    else if (strcmp(argv[i],"--check")     == 0) check_interval = atol(argv[++i]);
+    else if (strcmp(argv[i],"--checkpoint") == 0) checkpoint_file = argv[++i];
+    else if (strcmp(argv[i],"--checkpoint-every") == 0) checkpoint_interval = atol(argv[++i]);
+    else if (strcmp(argv[i],"--restart")   == 0) restart_file   = argv[++i];
+    else if (strcmp(argv[i],"--record")    == 0) record_file    = argv[++i];
+    else if (strcmp(argv[i],"--record-every") == 0) record_interval = atoi(argv[++i]);
+    else if (strcmp(argv[i],"--probe")     == 0) probe_blocks.push_back(atoi(argv[++i]));
+    else if (strcmp(argv[i],"--trajectory") == 0) trajectory_file = argv[++i];
+    else if (strcmp(argv[i],"--trajectory-every") == 0) trajectory_interval = atol(argv[++i]);
+    else if (strcmp(argv[i],"--ke-tol")    == 0) ke_tolerance   = atof(argv[++i]);
+    else {
+      Usage(argv[0]);
+      return 1;
+    }
+  } // for i = ...
+
+  // list a record catalog: file, number of points, time step, component and quantity
+  if (catalog_directory != nullptr) {
+    for (const GroundMotion::Record& record : GroundMotion::catalog(catalog_directory)) {
+      cout << record.filename << "\t" << record.npts << "\t" << record.dt << "\t" << record.description << "\t" << record.quantity << endl;
+    } // for record = ...
+    return 0;
+  }
+
+  // print the response spectra of a list of records: record, damping ratio, period, SD (cm), PSV (cm/s), PSA (g)
+  if (spectra_source != nullptr) {
+    vector<float> periods;
+    vector<float> damping;
+    if (!ParseList(periods_list, periods) || !ParseList(damping_list, damping) ||
+	any_of(periods.begin(), periods.end(), [](float T) { return (T <= 0.0); }) || any_of(damping.begin(), damping.end(), [](float z) { return (z < 0.0) || (z >= 1.0); })) {
+      Usage(argv[0]);
+      return 1;
+    }
+    vector<string> records;
+    if (filesystem::is_directory(spectra_source)) {
+      for (const GroundMotion::Record& record : GroundMotion::catalog(spectra_source)) {
+	if (record.quantity.find("ACCELERATION") != string::npos) records.push_back(record.filename);
+      } // for record = ...
+    } else {
+      ifstream file(spectra_source);
+      if (!file.is_open()) {
+	cerr << "ERROR: Unable to open record list " << spectra_source << endl;
+	return 1;
+      }
+      string line;
+      while (getline(file, line)) {
+	istringstream fields(line);
+	string record;
+	if ((fields >> record) && (record[0] != '#')) records.push_back(record);
+      } // while (getline(file, line))
+    }
+    auto start = chrono::steady_clock::now();
+    vector<GroundMotion::Spectra> spectra = GroundMotion::responseSpectra(records, periods, damping, threads, cache);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    cout << "record\tdamping\tperiod\tSD\tPSV\tPSA" << endl;
+    for (size_t i = 0; i < records.size(); i++) {
+      if (!spectra[i].ok) {
+	cerr << "ERROR: No response spectra for " << records[i] << endl;
+	continue;
+      }
+      for (size_t d = 0; d < damping.size(); d++) {
+	for (size_t p = 0; p < periods.size(); p++) {
+	  size_t j = d*periods.size() + p;
+	  cout << records[i] << "\t" << damping[d] << "\t" << periods[p] << "\t" << spectra[i].SD[j] << "\t" << spectra[i].PSV[j] << "\t" << spectra[i].PSA[j] << endl;
+	} // for p = ...
+      } // for d = ...
+    } // for i = ...
+    cerr << "response spectra of " << records.size() << " records in " << seconds << " s" << endl;
+    return 0;
+  }
+
+  bool gather = (strcmp(assembly,"gather") == 0);
+  if ((layout_file == nullptr) || ((ux_file == nullptr) && (ensemble_file == nullptr)) || (dt < 0.0) || (lanes < 1) || (lanes > ScenarioBatch::LANES) || ((lanes > 1) && (dt == 0.0)) || (safety <= 0.0) || (levels < 0) || (levels > 16) || (implicit < 0.0) || (sleep_steps < 0) || (split_fraction < 0.0) || (check_interval <= 0) || (checkpoint_interval < 0) || (record_interval <= 0) || (trajectory_interval <= 0) || (!gather && (strcmp(assembly,"colored") != 0))) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  CZM czm;
+
+  // populate material inventory
+  // (layouts may place single-cell "Player" blocks, which the demo leaves out of its palette)
+  czm.inventory.insertDefaultMaterials(true);
+
+  // load the material layout
+  if (!czm.grid.load(layout_file, czm.inventory)) return 1;
+
+  // run an ensemble of ground motions (each run on a single thread)
+  if (ensemble_file != nullptr) {
+    vector<Ensemble::Run> runs;
+    ifstream file(ensemble_file);
+    if (!file.is_open()) {
+      cerr << "ERROR: Unable to open ensemble file " << ensemble_file << endl;
+      return 1;
+    }
+    string line;
+    while (getline(file, line)) {
+      istringstream fields(line);
+      Ensemble::Run run;
+      if (!(fields >> run.ux) || (run.ux[0] == '#')) continue;
+      if (!(fields >> run.scale)) {
+	cerr << "ERROR: Invalid ensemble entry: " << line << endl;
+	return 1;
+      }
+      fields >> run.uy;
+      runs.push_back(run);
+    } // while (getline(file, line))
+    Ensemble ensemble;
+    ensemble.timescale = timescale;
+    ensemble.dt = dt;
+    ensemble.safety = safety;
+    ensemble.levels = levels;
+    ensemble.implicit = implicit;
+    ensemble.sleepSteps = sleep_steps;
+    ensemble.splitFraction = split_fraction;
+    ensemble.gather = gather;
+    ensemble.maxSubsteps = max_substeps;
+    ensemble.checkInterval = check_interval;
+    ensemble.keTolerance = ke_tolerance;
+    ensemble.cache = cache;
+    ensemble.lanes = lanes;
+    Checkpoint initial_state;
+    if (restart_file != nullptr) {
+      czm.simulation();
+      if (!czm.loadCheckpoint(restart_file)) return 1;
+      czm.saveState(initial_state);
+    }
+    auto start = chrono::steady_clock::now();
+    vector<Ensemble::Result> results = ensemble.run(czm.grid, runs, threads, (restart_file != nullptr) ? &initial_state : nullptr);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    cout << "run\tux\tscale\tcompleted\tsubsteps\ttime\tkinetic_energy\tfailed_faces\tfragments\tlargest_fragment\tsingle_blocks\twall_seconds" << endl;
+    for (size_t i = 0; i < runs.size(); i++) {
+      const Ensemble::Result& result = results[i];
+      cout << i << "\t" << runs[i].ux << "\t" << runs[i].scale << "\t" << result.completed << "\t" << result.substeps << "\t" << result.time << "\t"
+	   << result.kineticEnergy << "\t" << result.failedFaces << "\t" << result.fragments.count << "\t" << result.fragments.largest << "\t"
+	   << result.fragments.single << "\t" << result.wallSeconds << endl;
+    } // for i = ...
+    cerr << "ensemble of " << runs.size() << " runs in " << seconds << " s" << endl;
+    return 0;
+  }
+
+  // load the ground motion records
+  float record_dt;
+  if (!GroundMotion::readPEER(ux_file, czm.dispTimeHistory.ux, record_dt, cache)) return 1;
+  if (uy_file != nullptr) {
+    float uy_dt;
+    if (!GroundMotion::readPEER(uy_file, czm.dispTimeHistory.uy, uy_dt, cache)) return 1;
+    if (uy_dt != record_dt) {
+      cerr << "ERROR: The horizontal and vertical records have different time steps (" << record_dt << " and " << uy_dt << ")" << endl;
+      return 1;
+    }
+  } else {
+    czm.dispTimeHistory.uy.assign(czm.dispTimeHistory.ux.size(), 0.0);
+  }
+  czm.dispTimeHistory.dt = timescale*record_dt;
+  czm.dispTimeHistory.scale = scale;
+
+  // integrate until the substep budget is exhausted, or the shaking has ended and the motion has decayed
+  czm.simulation();
+  czm.setThreads(threads);
+  czm.safety = safety;
+  czm.maxLevel = levels;
+  czm.blocks.sleeping = (sleep_steps > 0);
+  czm.blocks.sleepSteps = sleep_steps;
+  czm.blocks.clustering = (split_fraction > 0.0);
+  czm.blocks.splitFraction = split_fraction;
+  if (implicit > 0.0) {
+    czm.integrator = CZM::Integrator::IMPLICIT;
+    czm.implicitScale = implicit;
+  }
+  bool automatic_dt = (dt == 0.0);
+  // (with a fixed substep, the ground increments of every substep are computed once, up front)
+  if (!automatic_dt) czm.dispTimeHistory.resample(dt);
+  if (gather) czm.faces.assembly = CohesiveZoneManager::Assembly::GATHER;
+  if ((restart_file != nullptr) && !czm.loadCheckpoint(restart_file)) return 1;
+  if (record_file != nullptr) {
+    czm.addStandardProbes();
+    for (int block : probe_blocks) {
+      if ((block < 0) || (block >= czm.blocks.Nblocks)) {
+	cerr << "ERROR: No block " << block << " to probe" << endl;
+	return 1;
+      }
+      czm.addBlockProbes(block);
+    } // for block = ...
+    size_t length = strlen(record_file);
+    bool binary = (length > 4) && (strcmp(record_file+length-4, ".bin") == 0);
+    czm.recorder.decimation = record_interval;
+    if (!czm.recorder.open(record_file, binary ? Recorder::Format::BINARY : Recorder::Format::CSV)) return 1;
+  }
+  Trajectory::Writer trajectory;
+  if ((trajectory_file != nullptr) && !trajectory.open(trajectory_file, czm.blocks.Nblocks)) return 1;
+  Coordinate shaking_duration = czm.dispTimeHistory.duration();
+  float kinetic_energy = 0.0;
+  Coordinate coarse_dt = dt;
+  long substeps = 0;
+  // (a restarted run keeps the step estimated before it was saved until its next check, as the saved run would)
+  long next_check = czm.substepsToCheck;
+  if (automatic_dt && (next_check > 0)) {
+    if (implicit > 0.0) {
+      dt = czm.estimatedDT;
+    } else {
+      coarse_dt = czm.estimatedDT;
+    }
+  }
+  long next_checkpoint = checkpoint_interval;
+  long next_frame = 0;
+  auto start = chrono::steady_clock::now();
+  while (substeps < max_substeps) {
+    // (the stable time step is re-estimated at every check, as failing faces relax it)
+    if (automatic_dt && (substeps >= next_check)) {
+      if (implicit > 0.0) {
+	dt = implicit*czm.stableTimeStep();
+      } else {
+	coarse_dt = czm.coarseTimeStep();
+      }
+    }
+    if (substeps >= next_check) next_check = substeps + check_interval;
+    if (automatic_dt && (implicit == 0.0)) {
+      // (one coarse step: a single substep, unless multi-rate levels are in use)
+      substeps += czm.coarseStep(coarse_dt);
+      dt = coarse_dt / (1 << czm.blocks.finestLevel);
+    } else {
+      czm.timeIntegrate(dt);
+      substeps++;
+    }
+    if ((trajectory_file != nullptr) && (substeps >= next_frame)) {
+      trajectory.addFrame(czm.time, czm.blocks);
+      next_frame = substeps + trajectory_interval;
+    }
+    if (substeps >= next_check) {
+      kinetic_energy = czm.blocks.kineticEnergy();
+      if ((czm.time > shaking_duration) && (kinetic_energy < ke_tolerance)) break;
+
+      // (checkpoints are saved at checks, where a restarted run re-estimates the time step as this one does)
+      if ((checkpoint_file != nullptr) && (checkpoint_interval > 0) && (substeps >= next_checkpoint)) {
+	czm.estimatedDT = (implicit > 0.0) ? dt : coarse_dt;
+	czm.substepsToCheck = next_check - substeps;
+	czm.saveCheckpoint(checkpoint_file);
+	next_checkpoint = substeps + checkpoint_interval;
+      }
+    }
+  } // while (substeps < max_substeps)
+  czm.recorder.close();
+  trajectory.close();
+  auto stop = chrono::steady_clock::now();
+  kinetic_energy = czm.blocks.kineticEnergy();
+  if (checkpoint_file != nullptr) {
+    // (the final state is saved wherever the run stopped, generally between checks)
+    czm.estimatedDT = (implicit > 0.0) ? dt : coarse_dt;
+    czm.substepsToCheck = next_check - substeps;
+    czm.saveCheckpoint(checkpoint_file);
+  }
+
+  // report run summary
+  double seconds = chrono::duration<double>(stop-start).count();
+  Blocks::FragmentStatistics fragments = czm.blocks.fragmentStatistics();
+  cout << "precision "      << precisionName()     << endl
+       << "blocks "         << czm.blocks.Nblocks  << endl
+       << "substeps "       << substeps            << endl
+       << "time "           << czm.time            << endl
+       << "dt "             << dt                  << endl
+       << "finest_level "   << czm.blocks.finestLevel << endl
+       << "cg_iterations "  << czm.solverIterations << endl
+       << "active_faces "   << czm.faces.activeFaces() << endl
+       << "sleeping_blocks " << czm.blocks.Nsleeping << endl
+       << "clusters "       << czm.blocks.Nclusters << endl
+       << "dofs "           << czm.blocks.degreesOfFreedom() << endl
+       << "fragments "      << fragments.count     << endl
+       << "largest_fragment " << fragments.largest << endl
+       << "single_blocks "  << fragments.single    << endl
+       << "mean_fragment_size " << fragments.meanSize << endl
+       << "kinetic_energy " << kinetic_energy      << endl
+       << "wall_seconds "   << seconds             << endl;
+
+  return 0;
+} // main()
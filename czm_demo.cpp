@@ -193,11 +193,8 @@ void InitCZM(void) {
 } // InitCZM()
 
 void Update(void) {
-  int Nsubincrements = 500;
-  float ddt = DT / Nsubincrements;
-  for (int i = 0; i < Nsubincrements; i++) {
-    czm.timeIntegrate(ddt);
-  } // for i = ...
+  // (the number of substeps follows from the stable time step of the current layout)
+  czm.advance(DT);
 
   glutPostRedisplay();
 } // Update()
@@ -339,49 +336,17 @@ int main(int argc, char** argv) {
 
   // populate material inventory
   Material::textures = LoadTexture("textures/textures.png");
-  czm.inventory.insertMaterial(new Material("Rock",      3500.0,      16, 0.38, 0.38, 0.38, 0.0, 0.0, 0.2, 0.2));
-  czm.inventory.insertMaterial(new Material("Soil",      1500.0,      64, 0.25, 0.50, 0.25, 0.2, 0.0, 0.4, 0.2));
-  czm.inventory.insertMaterial(new Material("Concrete",  2400.0,      32, 0.75, 0.75, 0.75, 0.4, 0.0, 0.6, 0.2));
-  czm.inventory.insertMaterial(new Material("Wood",       600.0,      32, 0.80, 0.45, 0.10, 0.6, 0.0, 0.8, 0.2));
-  czm.inventory.insertMaterial(new Material("Steel",     8050.0,      16, 0.50, 0.63, 0.70, 0.8, 0.0, 1.0, 0.2));
-  czm.inventory.insertMaterial(new Material("Brick",     2000.0,      32, 0.75, 0.10, 0.00, 0.0, 0.2, 0.2, 0.4));
-  //czm.inventory.insertMaterial(new Material("Water",     1000.0,      32, 0.29, 0.22, 1.00, 0.4, 0.2, 0.6, 0.4));
-  //czm.inventory.insertMaterial(new Material("Player",    1000.0,       1, 1.00, 0.00, 0.50, 0.6, 0.2, 0.8, 0.4));
+  czm.inventory.insertDefaultMaterials(false);
 
   // set default brush color
   czm.grid.brushColor = czm.inventory.getFirstMaterial();
 
-  czm.dispTimeHistory.ux.clear();
-  czm.dispTimeHistory.uy.clear();
-  czm.dispTimeHistory.dt = 0.25; // 0.005 s
+  // (the PEER header gives the record time step; 50 simulation time units per record second)
+  float record_dt;
+  GroundMotion::readPEER("ground_motions/sanfran/RSN23_SANFRAN_GGP100.DT2", czm.dispTimeHistory.ux, record_dt);
+  GroundMotion::readPEER("ground_motions/sanfran/RSN23_SANFRAN_GGP-UP.DT2", czm.dispTimeHistory.uy, record_dt);
+  czm.dispTimeHistory.dt = 50.0*record_dt; // 0.25 for 0.005 s
   czm.dispTimeHistory.scale = 10.0; // from cm to m
-  
-  string line;
-  float value;
-  std::ifstream file;
-  file.open ("ground_motions/sanfran/RSN23_SANFRAN_GGP100.DT2");
-  std::getline(file, line);
-  std::cout << line << std::endl;
-  std::getline(file, line);
-  std::cout << line << std::endl;
-  std::getline(file, line);
-  std::cout << line << std::endl;
-  std::getline(file, line);
-  std::cout << line << std::endl;
-  while (file >> value) czm.dispTimeHistory.ux.push_back(value);
-  file.close();
-
-  file.open ("ground_motions/sanfran/RSN23_SANFRAN_GGP-UP.DT2");
-  std::getline(file, line);
-  std::cout << line << std::endl;
-  std::getline(file, line);
-  std::cout << line << std::endl;
-  std::getline(file, line);
-  std::cout << line << std::endl;
-  std::getline(file, line);
-  std::cout << line << std::endl;
-  while (file >> value) czm.dispTimeHistory.uy.push_back(value);
-  file.close();
 
   glutMainLoop();
   return 0;
@@ -0,0 +1,45 @@
+// Trajectory inspector: lists the frames of a compressed trajectory file written by czm_batch --trajectory,
+// or prints the block positions and rotations of the given frames as CSV (in the order given)
+
+#include <vector>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Trajectory.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    cerr << "Usage: " << argv[0] << " <trajectory file> [frame ...]" << endl;
+    return 1;
+  }
+  Trajectory::Reader trajectory;
+  if (!trajectory.open(argv[1])) return 1;
+
+  // summary
+  if (argc == 2) {
+    cout << "blocks " << trajectory.blocks() << endl
+	 << "frames " << trajectory.frames() << endl;
+    if (trajectory.frames() > 0) {
+      cout << "first_time " << trajectory.time(0) << endl
+	   << "last_time "  << trajectory.time(trajectory.frames()-1) << endl;
+    }
+    return 0;
+  }
+
+  // the given frames, each read by seeking from the previous one (negative frames count from the end)
+  vector<float> px, py, rz;
+  for (int arg = 2; arg < argc; arg++) {
+    int frame = atoi(argv[arg]);
+    if (frame < 0) frame += trajectory.frames();
+    if (!trajectory.readFrame(frame, px, py, rz)) {
+      cerr << "ERROR: No frame " << argv[arg] << " in " << argv[1] << endl;
+      return 1;
+    }
+    printf("# time %.9g\nblock,x,y,rotation\n", trajectory.time(frame));
+    for (size_t i = 0; i < px.size(); i++) printf("%zu,%.9g,%.9g,%.9g\n", i, px[i], py[i], rz[i]);
+  } // for arg = ...
+  return 0;
+} // main()
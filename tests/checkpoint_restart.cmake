@@ -0,0 +1,24 @@
+# Regression check of checkpoint/restart: a multi-rate run split in two halves (saved between checks, and resumed
+# with --restart) must end in bitwise the same state as the same run taken straight through.
+#   cmake -DCZM_BATCH=<czm_batch> -DSOURCE_DIR=<repository> -DWORK_DIR=<scratch directory> -P checkpoint_restart.cmake
+
+set( ARGS --layout ${SOURCE_DIR}/layouts/tower.txt --ux ${SOURCE_DIR}/ground_motions/sanfran/RSN23_SANFRAN_GGP100.DT2
+          --scale 30000 --levels 3 --cache 0 )
+file( MAKE_DIRECTORY ${WORK_DIR} )
+
+function( run_batch )
+  execute_process( COMMAND ${CZM_BATCH} ${ARGS} ${ARGN} RESULT_VARIABLE status OUTPUT_QUIET )
+  if( NOT status EQUAL 0 )
+    message( FATAL_ERROR "czm_batch ${ARGN} failed (${status})" )
+  endif()
+endfunction()
+
+# (20000 substeps is a whole number of 8-substep coarse steps, but not of the 504-substep checks)
+run_batch( --substeps 40000 --checkpoint ${WORK_DIR}/straight.chk )
+run_batch( --substeps 20000 --checkpoint ${WORK_DIR}/first.chk )
+run_batch( --substeps 20000 --restart ${WORK_DIR}/first.chk --checkpoint ${WORK_DIR}/restarted.chk )
+
+execute_process( COMMAND ${CMAKE_COMMAND} -E compare_files ${WORK_DIR}/straight.chk ${WORK_DIR}/restarted.chk RESULT_VARIABLE differ )
+if( differ )
+  message( FATAL_ERROR "the restarted run does not end in the state of the uninterrupted run" )
+endif()
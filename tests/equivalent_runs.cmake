@@ -0,0 +1,28 @@
+# Regression check of run-to-run reproducibility: the same run under two settings that must not change its
+# result (e.g. thread counts, assembly modes or SIMD instruction sets) must end in bitwise the same state.
+#   cmake -DCZM_BATCH=<czm_batch> -DSOURCE_DIR=<repository> -DWORK_DIR=<scratch directory>
+#         -DFIRST=<options> -DSECOND=<options> [-DSECOND_SIMD=<CZM_SIMD>] -P equivalent_runs.cmake
+# (FIRST and SECOND are ;-separated czm_batch options, SECOND_SIMD caps the instruction set of the second run)
+
+# (shaken hard enough for faces to fail and fragments to come into contact)
+set( ARGS --layout ${SOURCE_DIR}/layouts/tower.txt --ux ${SOURCE_DIR}/ground_motions/sanfran/RSN23_SANFRAN_GGP100.DT2
+          --scale 100000 --substeps 40000 --cache 0 )
+file( MAKE_DIRECTORY ${WORK_DIR} )
+
+function( run_batch checkpoint simd )
+  if( simd )
+    set( launcher ${CMAKE_COMMAND} -E env CZM_SIMD=${simd} )
+  endif()
+  execute_process( COMMAND ${launcher} ${CZM_BATCH} ${ARGS} ${ARGN} --checkpoint ${checkpoint} RESULT_VARIABLE status OUTPUT_QUIET )
+  if( NOT status EQUAL 0 )
+    message( FATAL_ERROR "czm_batch ${ARGN} failed (${status})" )
+  endif()
+endfunction()
+
+run_batch( ${WORK_DIR}/first.chk "" ${FIRST} )
+run_batch( ${WORK_DIR}/second.chk "${SECOND_SIMD}" ${SECOND} )
+
+execute_process( COMMAND ${CMAKE_COMMAND} -E compare_files ${WORK_DIR}/first.chk ${WORK_DIR}/second.chk RESULT_VARIABLE differ )
+if( differ )
+  message( FATAL_ERROR "the runs with \"${FIRST}\" and \"${SECOND}\" do not end in the same state" )
+endif()
@@ -0,0 +1,53 @@
+// Regression check of multi-rate stepping: a free-floating bar of steel and soil (no gravity, no fixed blocks),
+// whose halves are thrown against each other, must conserve its linear momentum when its blocks are stepped at
+// different levels, as it does when stepped at a single rate.
+
+#include "CZM.h"
+#include <cstdio>
+#include <cmath>
+
+// mass-weighted mean x-velocity of the blocks
+double meanVelocity(const Blocks& blocks) {
+  double momentum = 0.0;
+  double mass = 0.0;
+  for (int i = 0; i < blocks.Nblocks; i++) {
+    momentum += double(blocks.mass[i])*blocks.vx[i];
+    mass += blocks.mass[i];
+  } // for i = ...
+  return momentum/mass;
+} // meanVelocity()
+
+// mean velocity after n coarse steps of a bar stepped with levels up to maxLevel (and the finest level used)
+double collide(int maxLevel, int n, int& finestLevel) {
+  CZM czm;
+  czm.inventory.insertDefaultMaterials(false);
+  czm.grid.initialize(14, 3, 14.0, 3.0);
+  for (int i = 1; i < 13; i++) czm.grid.cells[14+i] = czm.inventory.findMaterial((i < 7) ? "Steel" : "Soil");
+  czm.gravity = 0.0;
+  czm.dispTimeHistory.ux.assign(2, 0.0);
+  czm.dispTimeHistory.uy.assign(2, 0.0);
+  czm.simulation();
+  czm.maxLevel = maxLevel;
+  for (int i = 0; i < czm.blocks.Nblocks; i++) czm.blocks.vx[i] = (czm.blocks.mat[i]->name == "Steel") ? 0.1 : -0.1;
+  finestLevel = 0;
+  float dt = czm.coarseTimeStep();
+  for (int step = 0; step < n; step++) {
+    czm.coarseStep(dt);
+    finestLevel = std::max(finestLevel, czm.blocks.finestLevel);
+  } // for step = ...
+  return meanVelocity(czm.blocks);
+} // collide()
+
+int main() {
+  int singleLevel, multiLevel;
+  double initial = (6*8050.0*0.1 - 6*1500.0*0.1)/(6*8050.0 + 6*1500.0);
+  double single = collide(0, 4000, singleLevel);
+  double multi = collide(3, 4000, multiLevel);
+  printf("mean velocity: initial %.6e, single rate %.6e, multi-rate %.6e (finest level %d)\n", initial, single, multi, multiLevel);
+  double tolerance = 1.0e-5*fabs(initial);
+  if ((multiLevel == 0) || (fabs(single-initial) > tolerance) || (fabs(multi-initial) > tolerance)) {
+    printf("FAILED: the linear momentum is not conserved\n");
+    return 1;
+  }
+  return 0;
+} // main()
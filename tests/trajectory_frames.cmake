@@ -0,0 +1,100 @@
+# Regression check of the trajectory file: frames written every substep and read back through czm_trajectory (in an
+# order that seeks backwards and across chunk boundaries) must hold the positions recorded by --probe at the same
+# substeps, to within the quantization of the trajectory.
+#   cmake -DCZM_BATCH=<czm_batch> -DCZM_TRAJECTORY=<czm_trajectory> -DSOURCE_DIR=<repository> -DWORK_DIR=<scratch directory>
+#         -P trajectory_frames.cmake
+
+set( PROBES 40 150 )
+# (frames of 32-frame chunks: 31/32 and 63/64 straddle chunk boundaries, and 1500 to 31, 32 to 0 and the last to 63
+# seek backwards)
+set( FRAMES 1500 31 32 0 -1 63 64 1000 )
+# (half the 1e-4 quantum of the positions, and the rounding of both printouts, in micro length units)
+set( TOLERANCE 60 )
+
+file( MAKE_DIRECTORY ${WORK_DIR} )
+foreach( block ${PROBES} )
+  list( APPEND probe_args --probe ${block} )
+endforeach()
+execute_process( COMMAND ${CZM_BATCH} --layout ${SOURCE_DIR}/layouts/tower.txt --ux ${SOURCE_DIR}/ground_motions/sanfran/RSN23_SANFRAN_GGP100.DT2
+                         --scale 100000 --substeps 2000 --cache 0 --trajectory ${WORK_DIR}/run.traj --trajectory-every 1
+                         --record ${WORK_DIR}/run.csv ${probe_args}
+                 RESULT_VARIABLE status OUTPUT_QUIET )
+if( NOT status EQUAL 0 )
+  message( FATAL_ERROR "czm_batch failed (${status})" )
+endif()
+execute_process( COMMAND ${CZM_TRAJECTORY} ${WORK_DIR}/run.traj ${FRAMES} RESULT_VARIABLE status OUTPUT_VARIABLE frames )
+if( NOT status EQUAL 0 )
+  message( FATAL_ERROR "czm_trajectory failed (${status})" )
+endif()
+
+# a decimal number (without exponent, as positions of order one are printed) in micro length units
+function( to_micro number result )
+  if( NOT number MATCHES "^(-?)([0-9]+)\\.?([0-9]*)$" )
+    message( FATAL_ERROR "unexpected number ${number}" )
+  endif()
+  set( sign ${CMAKE_MATCH_1} )
+  set( whole ${CMAKE_MATCH_2} )
+  string( SUBSTRING "${CMAKE_MATCH_3}000000" 0 6 fraction )
+  string( REGEX REPLACE "^0+([0-9])" "\\1" fraction ${fraction} )
+  math( EXPR micro "${sign}(${whole}*1000000 + ${fraction})" )
+  set( ${result} ${micro} PARENT_SCOPE )
+endfunction()
+
+function( check_close what expected actual )
+  to_micro( ${expected} a )
+  to_micro( ${actual} b )
+  math( EXPR difference "${a} - ${b}" )
+  if( (difference GREATER TOLERANCE) OR (difference LESS -${TOLERANCE}) )
+    message( FATAL_ERROR "${what}: the trajectory holds ${actual}, the probe recorded ${expected}" )
+  endif()
+endfunction()
+
+# the recorded samples (one per substep, as the frames) and the columns of the probes
+file( STRINGS ${WORK_DIR}/run.csv record )
+list( GET record 0 header )
+string( REPLACE "," ";" header "${header}" )
+list( LENGTH record Nrecord )
+math( EXPR Nsamples "${Nrecord} - 1" )
+
+string( REPLACE "\n" ";" frames "${frames}" )
+set( checked 0 )
+set( request -1 )
+foreach( line ${frames} )
+  if( line MATCHES "^# time (.*)$" )
+    # the next requested frame, and the recorded sample of the same substep
+    set( time ${CMAKE_MATCH_1} )
+    math( EXPR request "${request} + 1" )
+    list( GET FRAMES ${request} frame )
+    if( frame LESS 0 )
+      math( EXPR frame "${frame} + ${Nsamples}" )
+    endif()
+    math( EXPR row "${frame} + 1" )
+    list( GET record ${row} sample )
+    string( REPLACE "," ";" sample "${sample}" )
+    list( GET sample 0 recorded_time )
+    if( NOT time STREQUAL recorded_time )
+      message( FATAL_ERROR "frame ${frame} is at time ${time}, its substep was recorded at ${recorded_time}" )
+    endif()
+  elseif( line MATCHES "^([0-9]+),([^,]+),([^,]+)," )
+    set( block ${CMAKE_MATCH_1} )
+    set( x ${CMAKE_MATCH_2} )
+    set( y ${CMAKE_MATCH_3} )
+    list( FIND PROBES ${block} probe )
+    if( probe GREATER -1 )
+      list( FIND header block${block}_x column )
+      list( GET sample ${column} recorded_x )
+      list( FIND header block${block}_y column )
+      list( GET sample ${column} recorded_y )
+      check_close( "block ${block} x at frame ${frame}" ${recorded_x} ${x} )
+      check_close( "block ${block} y at frame ${frame}" ${recorded_y} ${y} )
+      math( EXPR checked "${checked} + 1" )
+    endif()
+  endif()
+endforeach()
+
+list( LENGTH FRAMES Nframes )
+list( LENGTH PROBES Nprobes )
+math( EXPR expected "${Nframes} * ${Nprobes}" )
+if( NOT checked EQUAL expected )
+  message( FATAL_ERROR "czm_trajectory printed ${checked} probed positions, not ${expected}" )
+endif()